@@ -1,219 +1,158 @@
+// Console front end for the car rental engine.
+// Build with
+//   cmake -S . -B build && cmake --build build --target car_rental
+
+#include "rental_engine.h"
+#include "rental_protocol.h"
+
 #include <iostream>
 #include <vector>
 #include <string>
-#include <ctime>
 #include <limits>
-#include <algorithm>
 #include <iomanip>
 #include <fstream>
-#include <sstream>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
 
 using namespace std;
 
-// ==================== Date Structure and Functions ====================
+void clearInputBuffer() {
+    cin.clear();
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+}
+
+// ==================== Table Rendering ====================
+
+// Formats listing rows into one reusable buffer and writes it to stdout in
+// large chunks, instead of going through setw and endl for every cell.
+// Cells are left aligned and padded to the column width like setw; longer
+// values are written in full.
 
-struct Date {
-    int day;
-    int month;
-    int year;
+class TableWriter {
+private:
+    vector<int> widths;
+    string buffer;
+    size_t column;
     
-    Date() : day(1), month(1), year(2000) {}
-    Date(int d, int m, int y) : day(d), month(m), year(y) {}
+    static const size_t FLUSH_BYTES = 64 * 1024;
     
-    bool isValid() const {
-        if (year < 1900 || year > 2100) return false;
-        if (month < 1 || month > 12) return false;
-        
-        // Check days in month
-        int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-        
-        // Handle leap year for February
-        if (month == 2) {
-            bool isLeap = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
-            if (day < 1 || day > (isLeap ? 29 : 28)) return false;
-        } else {
-            if (day < 1 || day > daysInMonth[month-1]) return false;
+    void pad(size_t length) {
+        if (column < widths.size() && length < (size_t)widths[column]) {
+            buffer.append(widths[column] - length, ' ');
         }
-        
-        return true;
-    }
-    
-    bool operator<(const Date& other) const {
-        if (year != other.year) return year < other.year;
-        if (month != other.month) return month < other.month;
-        return day < other.day;
+        column++;
     }
     
-    bool operator<=(const Date& other) const {
-        return (*this < other) || (year == other.year && month == other.month && day == other.day);
-    }
-    
-    bool operator>(const Date& other) const {
-        return !(*this <= other);
+public:
+    explicit TableWriter(const vector<int>& columnWidths) : widths(columnWidths), column(0) {
+        buffer.reserve(FLUSH_BYTES + 1024);
     }
     
-    bool operator==(const Date& other) const {
-        return year == other.year && month == other.month && day == other.day;
+    ~TableWriter() {
+        flush();
     }
     
-    int differenceInDays(const Date& other) const {
-        // Simple calculation - for exact calculation we'd need more complex date math
-        int days1 = year * 365 + month * 30 + day;
-        int days2 = other.year * 365 + other.month * 30 + other.day;
-        return days2 - days1;
+    void header(const vector<string>& titles) {
+        int totalWidth = 0;
+        for (size_t i = 0; i < titles.size(); i++) {
+            cell(titles[i]);
+            totalWidth += widths[i];
+        }
+        endRow();
+        buffer.append(totalWidth, '-');
+        endRow();
     }
     
-    string toString() const {
-        return to_string(day) + "/" + to_string(month) + "/" + to_string(year);
+    TableWriter& cell(string_view text) {
+        buffer.append(text.data(), text.size());
+        pad(text.size());
+        return *this;
     }
     
-    string toFileString() const {
-        return to_string(day) + " " + to_string(month) + " " + to_string(year);
+    TableWriter& cell(int value) {
+        char digits[16];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        return cell(string_view(digits, result.ptr - digits));
     }
     
-    static Date fromString(const string& str) {
-        istringstream iss(str);
+    TableWriter& cell(const Date& date) {
         int d, m, y;
-        iss >> d >> m >> y;
-        return Date(d, m, y);
+        Date::civilFromDays(date.serial, d, m, y);
+        char text[32];
+        char* end = to_chars(text, text + 8, d).ptr;
+        *end++ = '/';
+        end = to_chars(end, end + 8, m).ptr;
+        *end++ = '/';
+        end = to_chars(end, end + 8, y).ptr;
+        return cell(string_view(text, end - text));
     }
-};
-
-Date getToday() {
-    time_t now = time(0);
-    tm* localtm = localtime(&now);
-    return Date(localtm->tm_mday, localtm->tm_mon + 1, localtm->tm_year + 1900);
-}
-
-void clearInputBuffer() {
-    cin.clear();
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-}
-
-// ==================== Car Structure ====================
-
-struct Car {
-    int id;
-    string company;
-    string model;
-    int dailyRent;
-    bool isAvailable;
     
-    Car() : id(-1), dailyRent(0), isAvailable(true) {} // Default constructor for file loading
-    
-    Car(int carId, const string& comp, const string& mod, int rent)
-        : id(carId), company(comp), model(mod), dailyRent(rent), isAvailable(true) {}
-    
-    string getFullName() const {
-        return company + " " + model;
+    // Unpadded text after the last column
+    TableWriter& text(string_view text) {
+        buffer.append(text.data(), text.size());
+        return *this;
     }
     
-    void display() const {
-        cout << left << setw(5) << id 
-             << setw(15) << company 
-             << setw(15) << model 
-             << setw(10) << dailyRent
-             << setw(12) << (isAvailable ? "Available" : "Rented") << endl;
-    }
-    
-    string toFileString() const {
-        return to_string(id) + "|" + company + "|" + model + "|" + 
-               to_string(dailyRent) + "|" + (isAvailable ? "1" : "0");
+    void endRow() {
+        buffer += '\n';
+        column = 0;
+        if (buffer.size() >= FLUSH_BYTES) {
+            flush();
+        }
     }
     
-    static Car fromString(const string& str) {
-        Car car;
-        size_t pos1 = str.find('|');
-        size_t pos2 = str.find('|', pos1 + 1);
-        size_t pos3 = str.find('|', pos2 + 1);
-        size_t pos4 = str.find('|', pos3 + 1);
-        
-        if (pos1 != string::npos && pos2 != string::npos && pos3 != string::npos && pos4 != string::npos) {
-            car.id = stoi(str.substr(0, pos1));
-            car.company = str.substr(pos1 + 1, pos2 - pos1 - 1);
-            car.model = str.substr(pos2 + 1, pos3 - pos2 - 1);
-            car.dailyRent = stoi(str.substr(pos3 + 1, pos4 - pos3 - 1));
-            car.isAvailable = (str.substr(pos4 + 1) == "1");
+    void flush() {
+        if (!buffer.empty()) {
+            cout.write(buffer.data(), buffer.size());
+            buffer.clear();
         }
-        return car;
+        cout.flush();
     }
 };
 
-// ==================== Rental Structure ====================
-
-struct Rental {
-    int id;
-    int carId;
-    string customerName;
-    Date rentDate;
-    Date returnDate;
-    int totalAmount;
-    bool isActive;
-    
-    Rental() : id(-1), carId(-1), totalAmount(0), isActive(false) {} // Default constructor
-    
-    Rental(int rentId, int cId, const string& cust, const Date& rDate, const Date& retDate, int amount)
-        : id(rentId), carId(cId), customerName(cust), rentDate(rDate), 
-          returnDate(retDate), totalAmount(amount), isActive(true) {}
-    
-    void display() const {
-        cout << left << setw(10) << id
-             << setw(25) << customerName
-             << setw(15) << rentDate.toString()
-             << setw(15) << returnDate.toString()
-             << setw(10) << totalAmount
-             << setw(10) << (isActive ? "Active" : "Returned") << endl;
-    }
-    
-    int calculateLateFee(int dailyRate, const Date& actualReturn) const {
-        if (actualReturn <= returnDate) return 0;
-        
-        int daysLate = actualReturn.differenceInDays(returnDate);
-        return daysLate * dailyRate * 1.5; // 50% late fee
-    }
-    
-    string toFileString() const {
-        return to_string(id) + "|" + to_string(carId) + "|" + customerName + "|" +
-               rentDate.toFileString() + "|" + returnDate.toFileString() + "|" +
-               to_string(totalAmount) + "|" + (isActive ? "1" : "0");
-    }
-    
-    static Rental fromString(const string& str) {
-        Rental rental;
-        vector<string> parts;
-        stringstream ss(str);
-        string part;
+// Reads a number from its own input line, using defaultValue when the line
+// is left empty.
+int readOptionalNumber(const string& prompt, int defaultValue) {
+    while (true) {
+        cout << prompt;
+        string line;
+        if (!getline(cin, line)) return defaultValue;
         
-        // Split by pipe
-        while (getline(ss, part, '|')) {
-            parts.push_back(part);
-        }
+        string_view text = line;
+        while (!text.empty() && isspace((unsigned char)text.back())) text.remove_suffix(1);
+        if (text.empty()) return defaultValue;
         
-        if (parts.size() >= 7) {
-            rental.id = stoi(parts[0]);
-            rental.carId = stoi(parts[1]);
-            rental.customerName = parts[2];
-            rental.rentDate = Date::fromString(parts[3]);
-            rental.returnDate = Date::fromString(parts[4]);
-            rental.totalAmount = stoi(parts[5]);
-            rental.isActive = (parts[6] == "1");
+        int value;
+        if (parseInt(text, value) && value >= 0) return value;
+        cout << "Please enter a non-negative number or leave it empty." << endl;
+    }
+}
+
+// Prompts until a valid dd mm yyyy date is entered.
+Date readDate(const string& prompt) {
+    while (true) {
+        cout << prompt;
+        int d, m, y;
+        if (cin >> d >> m >> y) {
+            clearInputBuffer();
+            if (Date::isValid(d, m, y)) return Date(d, m, y);
+            cout << "Invalid date! Please try again." << endl;
+        } else {
+            cout << "Invalid input format! Please use dd mm yyyy." << endl;
+            clearInputBuffer();
         }
-        return rental;
     }
-};
+}
 
 // ==================== Car Rental System Class ====================
 
+// Menu screens and batch mode on top of RentalEngine. All business rules
+// live in the engine; this class only prompts, prints and formats.
+
 class CarRentalSystem {
 private:
-    vector<Car> cars;
-    vector<Rental> rentals;
-    int nextCarId;
-    int nextRentalId;
-    
-    const string CARS_FILE = "cars_data.txt";
-    const string RENTALS_FILE = "rentals_data.txt";
-    const string ID_FILE = "id_counter.txt";
+    RentalEngine engine;
     
     void displayHeader(const string& title) {
         cout << "\n" << string(60, '=') << endl;
@@ -221,169 +160,35 @@ private:
         cout << string(60, '=') << endl;
     }
     
-    void displayTableHeader(const vector<string>& headers, const vector<int>& widths) {
-        for (size_t i = 0; i < headers.size(); i++) {
-            cout << left << setw(widths[i]) << headers[i];
-        }
-        cout << endl;
-        
-        // Calculate total width for the separator line
-        int totalWidth = 0;
-        for (int w : widths) {
-            totalWidth += w;
-        }
-        cout << string(totalWidth, '-') << endl;
-    }
+    // Interactive changes are journaled in the background, one write per
+    // burst, so a prompt never waits for the disk.
+    const chrono::milliseconds WRITE_BACK_INTERVAL = chrono::milliseconds(200);
     
-    Car* findCarById(int carId) {
-        for (auto& car : cars) {
-            if (car.id == carId) {
-                return &car;
-            }
-        }
-        return nullptr;
-    }
+    const vector<string> RENTAL_HEADERS = {"Rental ID", "Customer", "Rent Date", "Return Date", "Amount", "Status"};
+    const vector<int> RENTAL_WIDTHS = {10, 25, 15, 15, 10, 10};
     
-    Rental* findRentalById(int rentalId) {
-        for (auto& rental : rentals) {
-            if (rental.id == rentalId) {
-                return &rental;
-            }
-        }
-        return nullptr;
+    static const char* rentalStatus(const Rental& rental, const Date& today) {
+        if (!rental.isActive) return "Returned";
+        return rental.rentDate > today ? "Reserved" : "Active";
     }
     
-    void updateCarAvailability() {
-        Date today = getToday();
-        for (auto& rental : rentals) {
-            if (rental.isActive && today > rental.returnDate) {
-                rental.isActive = false;
-                Car* car = findCarById(rental.carId);
-                if (car) {
-                    car->isAvailable = true;
-                }
-            }
-        }
-    }
-    
-    // ========== FILE HANDLING METHODS ==========
-    
-    void saveCarsToFile() {
-        ofstream file(CARS_FILE);
-        if (!file.is_open()) {
-            cout << "Warning: Could not save cars data to file." << endl;
-            return;
-        }
-        
-        for (const auto& car : cars) {
-            file << car.toFileString() << endl;
-        }
-        file.close();
-    }
-    
-    void loadCarsFromFile() {
-        ifstream file(CARS_FILE);
-        if (!file.is_open()) {
-            cout << "No existing cars data found. Starting fresh." << endl;
-            return;
-        }
-        
-        cars.clear();
-        string line;
-        while (getline(file, line)) {
-            if (!line.empty()) {
-                Car car = Car::fromString(line);
-                cars.push_back(car);
-                if (car.id >= nextCarId) {
-                    nextCarId = car.id + 1;
-                }
-            }
-        }
-        file.close();
-        cout << "Loaded " << cars.size() << " cars from file." << endl;
-    }
-    
-    void saveRentalsToFile() {
-        ofstream file(RENTALS_FILE);
-        if (!file.is_open()) {
-            cout << "Warning: Could not save rentals data to file." << endl;
-            return;
-        }
+    void writeRentalRow(TableWriter& table, const Rental& rental, const Date& today) {
+        int carSlot = engine.findCar(rental.carId);
+        if (carSlot < 0) return;
         
-        for (const auto& rental : rentals) {
-            file << rental.toFileString() << endl;
-        }
-        file.close();
-    }
-    
-    void loadRentalsFromFile() {
-        ifstream file(RENTALS_FILE);
-        if (!file.is_open()) {
-            cout << "No existing rentals data found. Starting fresh." << endl;
-            return;
-        }
-        
-        rentals.clear();
-        string line;
-        while (getline(file, line)) {
-            if (!line.empty()) {
-                Rental rental = Rental::fromString(line);
-                rentals.push_back(rental);
-                if (rental.id >= nextRentalId) {
-                    nextRentalId = rental.id + 1;
-                }
-            }
-        }
-        file.close();
-        cout << "Loaded " << rentals.size() << " rentals from file." << endl;
-    }
-    
-    void saveIdCounters() {
-        ofstream file(ID_FILE);
-        if (!file.is_open()) {
-            cout << "Warning: Could not save ID counters to file." << endl;
-            return;
-        }
-        
-        file << nextCarId << endl;
-        file << nextRentalId << endl;
-        file.close();
-    }
-    
-    void loadIdCounters() {
-        ifstream file(ID_FILE);
-        if (!file.is_open()) {
-            cout << "No existing ID counters found. Starting fresh." << endl;
-            return;
-        }
-        
-        file >> nextCarId;
-        file >> nextRentalId;
-        file.close();
-    }
-    
-    void saveAllData() {
-        saveCarsToFile();
-        saveRentalsToFile();
-        saveIdCounters();
-        cout << "All data saved successfully." << endl;
-    }
-    
-    void loadAllData() {
-        loadIdCounters();
-        loadCarsFromFile();
-        loadRentalsFromFile();
-        updateCarAvailability(); // Update status based on current date
-        saveAllData(); // Save updated status back to file
+        table.cell(rental.id)
+             .cell(rental.customerName())
+             .cell(rental.rentDate)
+             .cell(rental.returnDate)
+             .cell(rental.totalAmount)
+             .cell(rentalStatus(rental, today))
+             .text(" [Car: ").text(engine.fleet().fullName(carSlot)).text("]");
+        table.endRow();
     }
 
 public:
-    CarRentalSystem() : nextCarId(1), nextRentalId(1) {
-        loadAllData(); // Load data from files on startup
-    }
-    
-    ~CarRentalSystem() {
-        saveAllData(); // Save data to files on exit
+    void startWriteBack() {
+        engine.setWriteBackInterval(WRITE_BACK_INTERVAL);
     }
     
     // ========== Feature 1: Add Car ==========
@@ -412,61 +217,59 @@ public:
             }
         }
         
-        cars.push_back(Car(nextCarId++, company, model, dailyRent));
-        saveCarsToFile(); // Save after adding
-        cout << "\nCar added successfully with ID: " << (nextCarId - 1) << endl;
+        Result<int> carId = engine.addCar(company, model, dailyRent);
+        cout << "\nCar added successfully with ID: " << carId.value << endl;
     }
     
     // ========== Feature 2: Show Available Cars ==========
     void showAvailableCars() {
-        updateCarAvailability();
+        engine.refresh();
         displayHeader("AVAILABLE CARS");
+        ScopedTimer timer(engine.statistics(), StatTimer::ListAvailable);
         
-        if (cars.empty()) {
+        const FleetTable& fleet = engine.fleet();
+        if (fleet.empty()) {
             cout << "No cars in the system. Please add cars first." << endl;
             return;
         }
         
-        vector<string> headers = {"ID", "Company", "Model", "Rate/Day", "Status"};
-        vector<int> widths = {5, 15, 15, 10, 12};
-        displayTableHeader(headers, widths);
+        TableWriter table({5, 15, 15, 10, 12});
+        table.header({"ID", "Company", "Model", "Rate/Day", "Status"});
         
-        bool foundAvailable = false;
-        for (const auto& car : cars) {
-            if (car.isAvailable) {
-                car.display();
-                foundAvailable = true;
-            }
+        vector<int> available = fleet.filterAvailable();
+        for (int carId : available) {
+            int carSlot = fleet.slotOf(carId);
+            table.cell(carId)
+                 .cell(fleet.company(carSlot))
+                 .cell(fleet.model(carSlot))
+                 .cell(fleet.dailyRent(carSlot))
+                 .cell("Available");
+            table.endRow();
         }
+        table.flush();
+        engine.statistics().add(StatCounter::RowsListed, available.size());
         
-        if (!foundAvailable) {
+        if (available.empty()) {
             cout << "No cars available for rent at the moment." << endl;
         }
     }
     
     // ========== Feature 3: Rent Car ==========
     void rentCar() {
-        updateCarAvailability();
+        engine.refresh();
         displayHeader("RENT A CAR");
         
         // Show available cars first
         showAvailableCars();
         
-        if (cars.empty()) {
+        const FleetTable& fleet = engine.fleet();
+        if (fleet.empty()) {
             cout << "Please add cars first." << endl;
             return;
         }
         
         // Check if any car is available
-        bool anyAvailable = false;
-        for (const auto& car : cars) {
-            if (car.isAvailable) {
-                anyAvailable = true;
-                break;
-            }
-        }
-        
-        if (!anyAvailable) {
+        if (!fleet.anyAvailable()) {
             cout << "No cars available for rent." << endl;
             return;
         }
@@ -476,14 +279,14 @@ public:
         cin >> carId;
         clearInputBuffer();
         
-        Car* car = findCarById(carId);
-        if (!car) {
-            cout << "Car ID not found!" << endl;
+        int carSlot = engine.findCar(carId);
+        if (carSlot < 0) {
+            cout << describeStatus(RentalStatus::CarNotFound) << endl;
             return;
         }
         
-        if (!car->isAvailable) {
-            cout << "Car is already rented!" << endl;
+        if (!fleet.isAvailable(carSlot)) {
+            cout << describeStatus(RentalStatus::CarNotAvailable) << endl;
             return;
         }
         
@@ -492,27 +295,22 @@ public:
         cout << "Enter customer name: ";
         getline(cin, customerName);
         
-        // Get return date
+        // Get return date and price it
         Date returnDate;
+        Result<int> totalAmount = RentalStatus::ReturnDateNotInFuture;
         while (true) {
             cout << "Enter return date (dd mm yyyy): ";
             int d, m, y;
             if (cin >> d >> m >> y) {
-                returnDate = Date(d, m, y);
-                if (!returnDate.isValid()) {
+                if (!Date::isValid(d, m, y)) {
                     cout << "Invalid date! Please try again." << endl;
                     continue;
                 }
+                returnDate = Date(d, m, y);
                 
-                Date today = getToday();
-                if (returnDate <= today) {
-                    cout << "Return date must be in the future!" << endl;
-                    continue;
-                }
-                
-                int rentalDays = returnDate.differenceInDays(today);
-                if (rentalDays > 365) {
-                    cout << "Maximum rental period is 1 year!" << endl;
+                totalAmount = engine.quote(carId, returnDate);
+                if (!totalAmount.ok()) {
+                    cout << totalAmount.message() << endl;
                     continue;
                 }
                 
@@ -524,22 +322,19 @@ public:
             }
         }
         
-        // Calculate total amount
         Date today = getToday();
-        int rentalDays = returnDate.differenceInDays(today);
-        int totalAmount = rentalDays * car->dailyRent;
         
         // Show summary
         cout << "\n" << string(50, '-') << endl;
         cout << "RENTAL SUMMARY" << endl;
         cout << string(50, '-') << endl;
-        cout << "Car: " << car->getFullName() << endl;
+        cout << "Car: " << fleet.fullName(carSlot) << endl;
         cout << "Customer: " << customerName << endl;
         cout << "Rental Date: " << today.toString() << endl;
         cout << "Return Date: " << returnDate.toString() << endl;
-        cout << "Daily Rate: " << car->dailyRent << endl;
-        cout << "Rental Days: " << rentalDays << endl;
-        cout << "Total Amount: " << totalAmount << endl;
+        cout << "Daily Rate: " << fleet.dailyRent(carSlot) << endl;
+        cout << "Rental Days: " << today.differenceInDays(returnDate) << endl;
+        cout << "Total Amount: " << totalAmount.value << endl;
         cout << string(50, '-') << endl;
         
         // Confirm
@@ -549,164 +344,156 @@ public:
         clearInputBuffer();
         
         if (tolower(confirm) == 'y') {
-            // Create rental record
-            Rental newRental(nextRentalId++, carId, customerName, today, returnDate, totalAmount);
-            rentals.push_back(newRental);
-            
-            // Update car availability
-            car->isAvailable = false;
-            
-            // Save both files after rental
-            saveCarsToFile();
-            saveRentalsToFile();
+            Result<Rental> rental = engine.rent(carId, customerName, returnDate);
+            if (!rental.ok()) {
+                cout << rental.message() << endl;
+                return;
+            }
             
             cout << "\nCar rented successfully!" << endl;
-            cout << "Rental ID: " << (nextRentalId - 1) << endl;
+            cout << "Rental ID: " << rental.value.id << endl;
             cout << "Keep this ID for returning the car." << endl;
         } else {
             cout << "Rental cancelled." << endl;
         }
     }
     
-    //  Feature 4: Show Rented Cars 
+    //  Feature 4: Show Rented Cars
     void showRentedCars() {
-        updateCarAvailability();
+        engine.refresh();
         displayHeader("CURRENTLY RENTED CARS");
+        ScopedTimer timer(engine.statistics(), StatTimer::ListRented);
         
-        if (rentals.empty()) {
+        if (engine.rentalCount() == 0) {
             cout << "No rental records found." << endl;
             return;
         }
         
-        vector<string> headers = {"Rental ID", "Customer", "Rent Date", "Return Date", "Amount", "Status"};
-        vector<int> widths = {10, 25, 15, 15, 10, 10};
-        displayTableHeader(headers, widths);
+        TableWriter table(RENTAL_WIDTHS);
+        table.header(RENTAL_HEADERS);
         
-        bool foundActive = false;
-        for (const auto& rental : rentals) {
-            if (rental.isActive) {
-                Car* car = findCarById(rental.carId);
-                if (car) {
-                    cout << left << setw(10) << rental.id
-                         << setw(25) << rental.customerName
-                         << setw(15) << rental.rentDate.toString()
-                         << setw(15) << rental.returnDate.toString()
-                         << setw(10) << rental.totalAmount
-                         << setw(10) << "Active"
-                         << " [Car: " << car->getFullName() << "]" << endl;
-                }
-                foundActive = true;
-            }
+        Date today = getToday();
+        for (const auto& rental : engine.activeRentals()) {
+            writeRentalRow(table, rental, today);
         }
+        table.flush();
+        engine.statistics().add(StatCounter::RowsListed, engine.activeRentals().size());
         
-        if (!foundActive) {
+        if (engine.activeRentals().empty()) {
             cout << "No cars are currently rented." << endl;
         }
     }
     
     // ========== Feature 5: Show Rental History ==========
     void showRentalHistory() {
-        updateCarAvailability();
+        engine.refresh();
         displayHeader("RENTAL HISTORY");
         
-        if (rentals.empty()) {
+        if (engine.rentalCount() == 0) {
             cout << "No rental history available." << endl;
             return;
         }
         
-        vector<string> headers = {"Rental ID", "Customer", "Rent Date", "Return Date", "Amount", "Status"};
-        vector<int> widths = {10, 25, 15, 15, 10, 10};
-        displayTableHeader(headers, widths);
+        size_t total = engine.rentalCount();
+        cout << total << " rental(s) on record." << endl;
+        size_t first = readOptionalNumber("Start from row (Enter for 1): ", 1);
+        size_t limit = readOptionalNumber("Rows to show (Enter for all): ", 0);
+        if (first == 0) first = 1;
+        if (limit == 0) limit = total;
         
-        for (const auto& rental : rentals) {
-            Car* car = findCarById(rental.carId);
-            if (car) {
-                cout << left << setw(10) << rental.id
-                     << setw(25) << rental.customerName
-                     << setw(15) << rental.rentDate.toString()
-                     << setw(15) << rental.returnDate.toString()
-                     << setw(10) << rental.totalAmount
-                     << setw(10) << (rental.isActive ? "Active" : "Returned")
-                     << " [Car: " << car->getFullName() << "]" << endl;
-            }
+        TableWriter table(RENTAL_WIDTHS);
+        table.header(RENTAL_HEADERS);
+        Date today = getToday();
+        size_t shown = engine.forEachHistory(first - 1, limit, [&](const Rental& rental) {
+            writeRentalRow(table, rental, today);
+        });
+        table.flush();
+        
+        if (shown == 0) {
+            cout << "No rentals in the selected range." << endl;
+        } else {
+            cout << "Showing rows " << first << "-" << (first + shown - 1)
+                 << " of " << total << "." << endl;
         }
     }
     
     // ========== Feature 6: Return Car ==========
     void returnCar() {
-        updateCarAvailability();
+        engine.refresh();
         displayHeader("RETURN A CAR");
         
         // Show active rentals
-        bool hasActiveRentals = false;
-        for (const auto& rental : rentals) {
-            if (rental.isActive) {
-                if (!hasActiveRentals) {
-                    cout << "Active Rentals:" << endl;
-                    cout << string(60, '-') << endl;
-                    cout << left << setw(10) << "ID" 
-                         << setw(25) << "Customer" 
-                         << setw(20) << "Car" 
-                         << setw(15) << "Return Date" << endl;
-                    cout << string(60, '-') << endl;
-                    hasActiveRentals = true;
-                }
-                
-                Car* car = findCarById(rental.carId);
-                if (car) {
-                    cout << left << setw(10) << rental.id
-                         << setw(25) << rental.customerName
-                         << setw(20) << car->getFullName()
-                         << setw(15) << rental.returnDate.toString() << endl;
+        if (engine.activeRentals().empty()) {
+            cout << "No active rentals to return." << endl;
+            return;
+        }
+        
+        // Narrow the list down to one customer when a name is given
+        string customerName;
+        cout << "Customer name (Enter to list all active rentals): ";
+        getline(cin, customerName);
+        
+        vector<Rental> rentals;
+        if (customerName.empty()) {
+            rentals = engine.activeRentalsSnapshot();
+        } else {
+            rentals = engine.customerRentals(customerName, true);
+            if (rentals.empty()) {
+                cout << "No active rentals for " << customerName << "." << endl;
+                vector<RentalEngine::CustomerSummary> matches = engine.findCustomers(customerName, 10);
+                if (!matches.empty()) {
+                    cout << "Customers starting with \"" << customerName << "\":" << endl;
+                    for (const auto& match : matches) {
+                        cout << "  " << match.name << " (" << match.activeRentals << " active)" << endl;
+                    }
                 }
+                return;
             }
         }
         
-        if (!hasActiveRentals) {
-            cout << "No active rentals to return." << endl;
-            return;
+        cout << "Active Rentals:" << endl;
+        TableWriter table({10, 25, 20, 15});
+        table.header({"ID", "Customer", "Car", "Return Date"});
+        for (const auto& rental : rentals) {
+            int carSlot = engine.findCar(rental.carId);
+            if (carSlot >= 0) {
+                table.cell(rental.id)
+                     .cell(rental.customerName())
+                     .cell(engine.fleet().fullName(carSlot))
+                     .cell(rental.returnDate);
+                table.endRow();
+            }
         }
+        table.flush();
         
         int rentalId;
         cout << "\nEnter Rental ID to return: ";
         cin >> rentalId;
         clearInputBuffer();
         
-        Rental* rental = findRentalById(rentalId);
-        if (!rental) {
-            cout << "Rental ID not found!" << endl;
-            return;
-        }
-        
-        if (!rental->isActive) {
-            cout << "This car has already been returned." << endl;
-            return;
-        }
-        
-        Car* car = findCarById(rental->carId);
-        if (!car) {
-            cout << "Error: Car not found!" << endl;
+        Result<int> lateFee = engine.lateFee(rentalId);
+        if (!lateFee.ok()) {
+            cout << lateFee.message() << endl;
             return;
         }
         
         // Check for late return
+        const Rental& rental = *engine.findRental(rentalId);
         Date actualReturn = getToday();
-        int lateFee = 0;
         
-        if (actualReturn > rental->returnDate) {
-            int daysLate = actualReturn.differenceInDays(rental->returnDate);
-            lateFee = daysLate * car->dailyRent * 1.5;
+        if (actualReturn > rental.returnDate) {
+            int daysLate = rental.returnDate.differenceInDays(actualReturn);
             
             cout << "\n" << string(50, '!') << endl;
             cout << "LATE RETURN DETECTED!" << endl;
             cout << string(50, '!') << endl;
-            cout << "Scheduled Return: " << rental->returnDate.toString() << endl;
+            cout << "Scheduled Return: " << rental.returnDate.toString() << endl;
             cout << "Actual Return: " << actualReturn.toString() << endl;
             cout << "Days Late: " << daysLate << endl;
-            cout << "Daily Rate: " << car->dailyRent << endl;
-            cout << "Late Fee (150%): " << lateFee << endl;
-            cout << "Original Amount: " << rental->totalAmount << endl;
-            cout << "New Total: " << (rental->totalAmount + lateFee) << endl;
+            cout << "Daily Rate: " << engine.fleet().dailyRent(engine.findCar(rental.carId)) << endl;
+            cout << "Late Fee (150%): " << lateFee.value << endl;
+            cout << "Original Amount: " << rental.totalAmount << endl;
+            cout << "New Total: " << (rental.totalAmount + lateFee.value) << endl;
             cout << string(50, '!') << endl;
             
             char confirm;
@@ -721,40 +508,402 @@ public:
         }
         
         // Process return
-        if (lateFee > 0) {
-            rental->totalAmount += lateFee;
+        Result<Rental> returned = engine.returnRental(rentalId);
+        if (!returned.ok()) {
+            cout << returned.message() << endl;
+            return;
         }
         
-        rental->isActive = false;
-        car->isAvailable = true;
-        
-        // Save data after return
-        saveCarsToFile();
-        saveRentalsToFile();
+        if (returned.value.rentDate > actualReturn) {
+            cout << "\nReservation cancelled. No charge." << endl;
+            return;
+        }
         
         cout << "\nCar returned successfully!" << endl;
-        cout << "Final amount: " << rental->totalAmount << endl;
+        cout << "Final amount: " << returned.value.totalAmount << endl;
         
-        if (actualReturn < rental->returnDate) {
+        if (actualReturn < returned.value.returnDate) {
             cout << "Note: Early return. No refund for unused days." << endl;
         }
     }
     
-    // ========== Feature 7: Backup Data ==========
+    // ========== Feature 7: Reserve Car ==========
+    void reserveCar() {
+        engine.refresh();
+        displayHeader("RESERVE A CAR");
+        
+        if (engine.fleet().empty()) {
+            cout << "Please add cars first." << endl;
+            return;
+        }
+        
+        Date startDate = readDate("Enter start date (dd mm yyyy): ");
+        Date returnDate = readDate("Enter return date (dd mm yyyy): ");
+        
+        vector<int> free = engine.freeCars(startDate, returnDate);
+        if (free.empty()) {
+            cout << "No cars are free for those dates." << endl;
+            return;
+        }
+        
+        const FleetTable& fleet = engine.fleet();
+        TableWriter table({5, 15, 15, 10});
+        table.header({"ID", "Company", "Model", "Rate/Day"});
+        for (int carId : free) {
+            int carSlot = fleet.slotOf(carId);
+            table.cell(carId)
+                 .cell(fleet.company(carSlot))
+                 .cell(fleet.model(carSlot))
+                 .cell(fleet.dailyRent(carSlot));
+            table.endRow();
+        }
+        table.flush();
+        
+        int carId;
+        cout << "\nEnter Car ID to reserve: ";
+        cin >> carId;
+        clearInputBuffer();
+        
+        Result<int> totalAmount = engine.quote(carId, startDate, returnDate);
+        if (!totalAmount.ok()) {
+            cout << totalAmount.message() << endl;
+            return;
+        }
+        
+        string customerName;
+        cout << "Enter customer name: ";
+        getline(cin, customerName);
+        
+        int carSlot = fleet.slotOf(carId);
+        cout << "\n" << string(50, '-') << endl;
+        cout << "RESERVATION SUMMARY" << endl;
+        cout << string(50, '-') << endl;
+        cout << "Car: " << fleet.fullName(carSlot) << endl;
+        cout << "Customer: " << customerName << endl;
+        cout << "Start Date: " << startDate.toString() << endl;
+        cout << "Return Date: " << returnDate.toString() << endl;
+        cout << "Daily Rate: " << fleet.dailyRent(carSlot) << endl;
+        cout << "Rental Days: " << startDate.differenceInDays(returnDate) << endl;
+        cout << "Total Amount: " << totalAmount.value << endl;
+        cout << string(50, '-') << endl;
+        
+        char confirm;
+        cout << "\nConfirm reservation? (y/n): ";
+        cin >> confirm;
+        clearInputBuffer();
+        
+        if (tolower(confirm) != 'y') {
+            cout << "Reservation cancelled." << endl;
+            return;
+        }
+        
+        Result<Rental> rental = engine.reserve(carId, customerName, startDate, returnDate);
+        if (!rental.ok()) {
+            cout << rental.message() << endl;
+            return;
+        }
+        
+        cout << "\nCar reserved successfully!" << endl;
+        cout << "Rental ID: " << rental.value.id << endl;
+        cout << "Keep this ID to cancel or return the car." << endl;
+    }
+    
+    // ========== Feature 8: Availability Calendar ==========
+    void showAvailabilityCalendar() {
+        engine.refresh();
+        displayHeader("AVAILABILITY CALENDAR");
+        
+        const FleetTable& fleet = engine.fleet();
+        if (fleet.empty()) {
+            cout << "No cars in the system. Please add cars first." << endl;
+            return;
+        }
+        
+        string company;
+        cout << "Company (Enter for the whole fleet): ";
+        getline(cin, company);
+        int days = readOptionalNumber("Days to show (Enter for 30): ", 30);
+        if (days == 0) days = 30;
+        
+        size_t carCount = fleet.countCompany(company);
+        if (carCount == 0) {
+            cout << "No cars from " << company << " in the fleet." << endl;
+            return;
+        }
+        
+        Date today = getToday();
+        Result<vector<int>> counts = engine.freeCarsPerDay(today, days, company);
+        if (!counts.ok()) {
+            cout << counts.message() << endl;
+            return;
+        }
+        
+        TableWriter table({15, 10, 10});
+        table.header({"Date", "Free", "Booked"});
+        for (int i = 0; i < days; i++) {
+            table.cell(Date::fromSerial(today.serial + i))
+                 .cell(counts.value[i])
+                 .cell((int)carCount - counts.value[i]);
+            table.endRow();
+        }
+        table.flush();
+        cout << carCount << " car(s) " << (company.empty() ? "in the fleet" : "from " + company) << "." << endl;
+    }
+    
+    // ========== Feature 9: Revenue Report ==========
+    void showRevenueReport() {
+        engine.refresh();
+        displayHeader("REVENUE REPORT");
+        
+        const FleetTable& fleet = engine.fleet();
+        if (fleet.empty()) {
+            cout << "No cars in the system. Please add cars first." << endl;
+            return;
+        }
+        
+        Date today = getToday();
+        int year = readOptionalNumber("Year (Enter for " + to_string(today.year()) + "): ", today.year());
+        if (year < 1900 || year > 2100) {
+            cout << "Please enter a year between 1900 and 2100." << endl;
+            return;
+        }
+        
+        // Utilization is rented car-days over car-days of the current fleet
+        auto percent = [&](int64_t rentedDays, int days) {
+            char text[16];
+            snprintf(text, sizeof(text), "%.1f%%", 100.0 * rentedDays / ((double)fleet.size() * days));
+            return string(text);
+        };
+        
+        static const char* MONTHS[] = {"January", "February", "March", "April", "May", "June", "July",
+                                       "August", "September", "October", "November", "December"};
+        TableWriter months({12, 14, 12, 12});
+        months.header({"Month", "Revenue", "Car-Days", "Utilization"});
+        for (int month = 1; month <= 12; month++) {
+            Date first(1, month, year);
+            Date next = month == 12 ? Date(1, 1, year + 1) : Date(1, month + 1, year);
+            UsageTotals totals = engine.usageBetween(first, Date::fromSerial(next.serial - 1));
+            months.cell(MONTHS[month - 1])
+                  .cell(to_string(totals.revenue))
+                  .cell(to_string(totals.rentedDays))
+                  .cell(percent(totals.rentedDays, first.differenceInDays(next)));
+            months.endRow();
+        }
+        Date yearStart(1, 1, year), yearEnd(31, 12, year);
+        UsageTotals yearTotals = engine.usageBetween(yearStart, yearEnd);
+        months.cell("Total")
+              .cell(to_string(yearTotals.revenue))
+              .cell(to_string(yearTotals.rentedDays))
+              .cell(percent(yearTotals.rentedDays, yearStart.differenceInDays(yearEnd) + 1));
+        months.endRow();
+        months.flush();
+        
+        cout << "\nAll-time totals by company:" << endl;
+        TableWriter companies({15, 6, 14, 12});
+        companies.header({"Company", "Cars", "Revenue", "Car-Days"});
+        for (const auto& usage : engine.companyUsage()) {
+            companies.cell(usage.company)
+                     .cell(usage.cars)
+                     .cell(to_string(usage.totals.revenue))
+                     .cell(to_string(usage.totals.rentedDays));
+            companies.endRow();
+        }
+        companies.flush();
+        
+        vector<pair<int64_t, int>> carRevenue;
+        for (size_t i = 0; i < fleet.size(); i++) {
+            Result<UsageTotals> usage = engine.carUsage(fleet.id(i));
+            if (usage.ok()) carRevenue.push_back({usage.value.revenue, fleet.id(i)});
+        }
+        size_t shown = min<size_t>(10, carRevenue.size());
+        partial_sort(carRevenue.begin(), carRevenue.begin() + shown, carRevenue.end(),
+                     [](const pair<int64_t, int>& a, const pair<int64_t, int>& b) { return a.first > b.first; });
+        
+        cout << "\nTop cars by all-time revenue:" << endl;
+        TableWriter cars({5, 30, 14, 12});
+        cars.header({"ID", "Car", "Revenue", "Car-Days"});
+        for (size_t i = 0; i < shown; i++) {
+            int carId = carRevenue[i].second;
+            cars.cell(carId)
+                .cell(fleet.fullName(fleet.slotOf(carId)))
+                .cell(to_string(carRevenue[i].first))
+                .cell(to_string(engine.carUsage(carId).value.rentedDays));
+            cars.endRow();
+        }
+        cars.flush();
+    }
+    
+    // ========== Feature 10: Search Cars ==========
+    void searchCars() {
+        engine.refresh();
+        displayHeader("SEARCH CARS");
+        
+        if (engine.fleet().empty()) {
+            cout << "No cars in the system. Please add cars first." << endl;
+            return;
+        }
+        
+        FleetQuery query;
+        cout << "Company (Enter for any): ";
+        getline(cin, query.company);
+        cout << "Model contains (Enter for any): ";
+        getline(cin, query.modelContains);
+        query.minRent = readOptionalNumber("Lowest daily rate (Enter for any): ", 0);
+        int maxRent = readOptionalNumber("Highest daily rate (Enter for any): ", 0);
+        if (maxRent > 0) query.maxRent = maxRent;
+        
+        char answer = 'y';
+        cout << "Available cars only? (y/n): ";
+        cin >> answer;
+        clearInputBuffer();
+        query.availableOnly = tolower(answer) == 'y';
+        
+        int order = readOptionalNumber("Order: 1. Fleet  2. Cheapest first  3. Priciest first (Enter for 1): ", 1);
+        if (order == 2) query.order = FleetQuery::Order::RentAscending;
+        if (order == 3) query.order = FleetQuery::Order::RentDescending;
+        query.limit = readOptionalNumber("Cars to show (Enter for 10): ", 10);
+        
+        FleetQueryPlan plan;
+        vector<Car> cars = engine.findCars(query, &plan);
+        
+        TableWriter table({5, 15, 15, 10, 12});
+        table.header({"ID", "Company", "Model", "Rate/Day", "Status"});
+        for (const Car& car : cars) {
+            table.cell(car.id)
+                 .cell(symbols().name(car.company))
+                 .cell(symbols().name(car.model))
+                 .cell(car.dailyRent)
+                 .cell(car.isAvailable ? "Available" : "Rented");
+            table.endRow();
+        }
+        table.flush();
+        
+        if (cars.empty()) {
+            cout << "No cars match the search." << endl;
+        } else {
+            cout << cars.size() << " car(s) found, " << plan.examined
+                 << " checked (" << plan.index << ")." << endl;
+        }
+    }
+    
+    // ========== Feature 11: Backup Data ==========
     void backupData() {
         displayHeader("BACKUP DATA");
-        saveAllData();
+        engine.save();
         cout << "All data has been backed up to files." << endl;
         cout << "Files created: " << endl;
-        cout << "1. " << CARS_FILE << " (Cars data)" << endl;
-        cout << "2. " << RENTALS_FILE << " (Rentals data)" << endl;
-        cout << "3. " << ID_FILE << " (ID counters)" << endl;
+        int number = 1;
+        for (const auto& file : engine.dataFiles()) {
+            cout << number++ << ". " << file.first << " (" << file.second << ")" << endl;
+        }
+    }
+    
+    // ========== Feature 12: Engine Statistics ==========
+    void showStatistics() {
+        displayHeader("ENGINE STATISTICS");
+        if (!EngineStats::ENABLED) {
+            cout << "Statistics were compiled out of this build (RENTAL_NO_STATS)." << endl;
+            return;
+        }
+        
+        const EngineStats& stats = engine.statistics();
+        auto micros = [](uint64_t nanos) {
+            char text[32];
+            snprintf(text, sizeof(text), "%.1f", nanos / 1000.0);
+            return string(text);
+        };
+        
+        cout << "Latencies in microseconds since startup:" << endl;
+        TableWriter timers({16, 10, 12, 12, 12, 12, 12});
+        timers.header({"Operation", "Count", "Mean", "p50", "p90", "p99", "Max"});
+        for (int i = 0; i < (int)StatTimer::Count; i++) {
+            const LatencyHistogram& histogram = stats.timer((StatTimer)i);
+            if (histogram.count() == 0) continue;
+            timers.cell(statName((StatTimer)i))
+                  .cell(to_string(histogram.count()))
+                  .cell(micros(histogram.mean()))
+                  .cell(micros(histogram.percentile(0.5)))
+                  .cell(micros(histogram.percentile(0.9)))
+                  .cell(micros(histogram.percentile(0.99)))
+                  .cell(micros(histogram.maximum()));
+            timers.endRow();
+        }
+        timers.flush();
+        
+        cout << endl;
+        TableWriter counters({28, 16});
+        counters.header({"Counter", "Value"});
+        for (int i = 0; i < (int)StatCounter::Count; i++) {
+            counters.cell(statName((StatCounter)i)).cell(to_string(stats.counter((StatCounter)i)));
+            counters.endRow();
+        }
+        counters.flush();
+    }
+    
+    // ========== Batch Mode ==========
+    // Runs protocol commands (see rental_protocol.h) from a stream without
+    // prompts, one per line. Blank lines and lines starting with '#' are
+    // skipped. All changes are journaled together when the batch ends.
+    void runBatch(istream& in) {
+        auto started = chrono::steady_clock::now();
+        size_t commands = 0;
+        size_t errors = 0;
+        string out;
+        
+        engine.refresh();
+        engine.beginBatch();
+        
+        string line;
+        while (getline(in, line)) {
+            string_view rest = line;
+            if (!rest.empty() && rest.back() == '\r') rest.remove_suffix(1);
+            if (rest.empty() || rest.front() == '#') continue;
+            
+            commands++;
+            if (!runCommand(engine, rest, out)) {
+                errors++;
+            }
+            if (out.size() >= 64 * 1024) {
+                cout << out;
+                out.clear();
+            }
+        }
+        cout << out << flush;
+        
+        engine.commitBatch();
+        
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        cerr << "Processed " << commands << " command(s), " << errors << " error(s) in "
+             << fixed << setprecision(3) << seconds << " s ("
+             << (seconds > 0 ? (size_t)(commands / seconds) : commands) << " ops/sec)" << endl;
+    }
+    
+    // ========== Server Mode ==========
+    // Keeps the data in memory and answers protocol commands from many
+    // desks over a socket until interrupted.
+    int serve(const string& address) {
+        return runServer(engine, address);
     }
     
-    // ========== Feature 8: Exit ==========
+    // ========== Snapshot Conversion ==========
+    void convertStorage(bool toBinary) {
+        if (!engine.convertStorage(toBinary)) {
+            cout << "Data is already stored in " << (toBinary ? "binary" : "text") << " format." << endl;
+            return;
+        }
+        
+        vector<pair<string, string>> files = engine.dataFiles();
+        if (toBinary) {
+            cout << "Converted data to " << files[0].first << "." << endl;
+        } else {
+            cout << "Converted data to " << files[0].first << " and " << files[1].first << "." << endl;
+        }
+    }
+    
+    // ========== Feature 13: Exit ==========
     void exitSystem() {
         displayHeader("THANK YOU");
-        saveAllData();
+        engine.save();
         cout << "All data saved to files." << endl;
         cout << "Goodbye! Have a great day!" << endl;
     }
@@ -772,22 +921,55 @@ void displayMainMenu() {
     cout << "4. View Rented Cars" << endl;
     cout << "5. View Rental History" << endl;
     cout << "6. Return a Car" << endl;
-    cout << "7. Backup Data" << endl;
-    cout << "8. Exit" << endl;
+    cout << "7. Reserve a Car" << endl;
+    cout << "8. Availability Calendar" << endl;
+    cout << "9. Revenue Report" << endl;
+    cout << "10. Search Cars" << endl;
+    cout << "11. Backup Data" << endl;
+    cout << "12. Engine Statistics" << endl;
+    cout << "13. Exit" << endl;
     cout << string(50, '-') << endl;
-    cout << "Enter your choice (1-8): ";
+    cout << "Enter your choice (1-13): ";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     CarRentalSystem system;
     int choice;
     
+    if (argc > 1) {
+        string option = argv[1];
+        if (option == "--to-binary" || option == "--to-text") {
+            system.convertStorage(option == "--to-binary");
+            return 0;
+        }
+        if (option == "--batch" && argc > 2) {
+            string path = argv[2];
+            if (path == "-") {
+                system.runBatch(cin);
+            } else {
+                ifstream commands(path);
+                if (!commands.is_open()) {
+                    cout << "Could not open batch file: " << path << endl;
+                    return 1;
+                }
+                system.runBatch(commands);
+            }
+            return 0;
+        }
+        if (option == "--serve" && argc > 2) {
+            return system.serve(argv[2]);
+        }
+        cout << "Usage: " << argv[0] << " [--to-binary | --to-text | --batch <file or -> | --serve <port or socket path>]" << endl;
+        return 1;
+    }
+    
     cout << "\n" << string(60, '*') << endl;
     cout << "      WELCOME TO CAR RENTAL MANAGEMENT SYSTEM" << endl;
     cout << string(60, '*') << endl;
     
     cout << "\nNote: Data is automatically loaded from files on startup." << endl;
     cout << "      Data is automatically saved to files on exit." << endl;
+    system.startWriteBack();
     
     do {
         displayMainMenu();
@@ -821,16 +1003,31 @@ int main() {
                 system.returnCar();
                 break;
             case 7:
-                system.backupData();
+                system.reserveCar();
                 break;
             case 8:
+                system.showAvailabilityCalendar();
+                break;
+            case 9:
+                system.showRevenueReport();
+                break;
+            case 10:
+                system.searchCars();
+                break;
+            case 11:
+                system.backupData();
+                break;
+            case 12:
+                system.showStatistics();
+                break;
+            case 13:
                 system.exitSystem();
                 break;
             default:
-                cout << "Invalid choice! Please enter 1-8." << endl;
+                cout << "Invalid choice! Please enter 1-13." << endl;
         }
         
-    } while (choice != 8);
+    } while (choice != 13);
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,515 @@
+// Benchmark suite for the rental engine. Generates a synthetic fleet and
+// rental history in the cars_data.txt / rentals_data.txt formats, times
+// the engine's main paths on it and prints one result row per scenario
+// as CSV or JSON, so runs can be compared across releases.
+// Build with
+//   cmake -S . -B build && cmake --build build --target rental_bench
+// Usage:
+//   rental_bench [--cars N] [--rentals N] [--ops N] [--transactions N]
+//                [--threads N] [--format csv|json] [--dir path]
+// The data is written to a fresh temporary directory, removed at the end,
+// unless --dir names one to keep.
+
+#include "rental_engine.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// ==================== Allocation Counting ====================
+
+// Every scenario reports how many allocations it made, so regressions in
+// the zero-allocation paths show up next to the timings.
+
+static atomic<size_t> allocationCount(0);
+static atomic<size_t> allocatedBytes(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    if (void* memory = malloc(size ? size : 1)) return memory;
+    throw bad_alloc();
+}
+
+// GCC takes free() here for a mismatch with the replaced operator new
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+#pragma GCC diagnostic pop
+
+// ==================== Data Generator ====================
+
+struct BenchConfig {
+    size_t cars = 10000;
+    size_t rentals = 200000;
+    size_t ops = 200000;
+    size_t transactions = 5000;
+    size_t threads = 8;
+    string format = "csv";
+    string directory;
+};
+
+const char* const COMPANIES[] = {"Toyota", "Honda", "Ford", "Hyundai", "Kia", "Nissan",
+                                 "Mazda", "Volkswagen", "BMW", "Tesla"};
+const char* const MODELS[] = {"Compact", "Sedan", "Hatchback", "Wagon", "Coupe",
+                              "SUV", "Crossover SUV", "Pickup", "Minivan", "EV"};
+
+void appendRental(string& out, size_t id, size_t carId, size_t customer,
+                  int32_t first, int32_t last, int amount, bool active) {
+    appendInt(out, id);
+    out += '|';
+    appendInt(out, carId);
+    out += "|Customer ";
+    appendInt(out, customer);
+    out += '|';
+    Date::fromSerial(first).appendTo(out);
+    out += '|';
+    Date::fromSerial(last).appendTo(out);
+    out += '|';
+    appendInt(out, amount);
+    out += active ? "|1\n" : "|0\n";
+}
+
+// Writes config.cars cars and about config.rentals rentals. A third of
+// the cars are out today and another third have a reservation starting
+// next week; the rest of the rentals are returned history spread over
+// the last three years.
+void generateData(const BenchConfig& config, mt19937& random) {
+    vector<int> rents(config.cars);
+    string out;
+    for (size_t i = 0; i < config.cars; i++) {
+        rents[i] = 20 + random() % 480;
+        appendInt(out, i + 1);
+        out += '|';
+        out += COMPANIES[random() % size(COMPANIES)];
+        out += '|';
+        out += MODELS[random() % size(MODELS)];
+        out += '|';
+        appendInt(out, rents[i]);
+        out += "|1\n";
+    }
+    ofstream(config.directory + "/cars_data.txt").write(out.data(), out.size());
+
+    int32_t today = getToday().serial;
+    size_t customers = max<size_t>(1, config.rentals / 10);
+    size_t booked = min(config.rentals, config.cars / 3 * 2);
+    size_t id = 1;
+    out.clear();
+    ofstream rentals(config.directory + "/rentals_data.txt");
+    for (; id <= config.rentals - booked; id++) {
+        size_t car = random() % config.cars;
+        int32_t first = today - 1095 + random() % 1080;
+        int32_t last = first + 1 + random() % 14;
+        appendRental(out, id, car + 1, 1 + random() % customers, first, last,
+                     (last - first) * rents[car], false);
+        if (out.size() >= (1 << 20)) {
+            rentals.write(out.data(), out.size());
+            out.clear();
+        }
+    }
+    for (size_t i = 0; i < booked; i++, id++) {
+        size_t car = i % (config.cars / 3 * 2);
+        bool current = car < config.cars / 3;
+        int32_t first = current ? today - (int32_t)(random() % 3) : today + 7 + random() % 7;
+        int32_t last = current ? today + 1 + random() % 10 : first + 1 + random() % 10;
+        appendRental(out, id, car + 1, 1 + random() % customers, first, last,
+                     (last - first) * rents[car], true);
+    }
+    rentals.write(out.data(), out.size());
+}
+
+// ==================== Measurement ====================
+
+struct Measurement {
+    string scenario;
+    size_t items;
+    double seconds;
+    size_t allocations;
+    size_t bytes;
+    size_t failures;
+};
+
+vector<Measurement> results;
+
+// Operations a scenario attempted but the engine refused. They are not
+// counted as items, and a run that breaks an engine invariant fails.
+static atomic<size_t> failureCount(0);
+static atomic<bool> invariantBroken(false);
+
+// Runs body once and records its time and allocations. body returns the
+// number of items it handled, which the per-item figures are based on.
+template <typename Body>
+void measure(const string& scenario, Body body) {
+    cerr << "Running " << scenario << "..." << endl;
+    size_t allocationsBefore = allocationCount.load();
+    size_t bytesBefore = allocatedBytes.load();
+    failureCount = 0;
+    auto started = chrono::steady_clock::now();
+    size_t items = body();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    results.push_back({scenario, items, seconds, allocationCount.load() - allocationsBefore,
+                       allocatedBytes.load() - bytesBefore, failureCount.load()});
+}
+
+void printResults(const BenchConfig& config) {
+    auto perSecond = [](const Measurement& m) { return m.seconds > 0 ? m.items / m.seconds : 0.0; };
+    auto nsPerItem = [](const Measurement& m) { return m.items ? m.seconds * 1e9 / m.items : 0.0; };
+
+    if (config.format == "json") {
+        cout << "{\"cars\": " << config.cars << ", \"rentals\": " << config.rentals
+             << ", \"threads\": " << config.threads << ", \"results\": [" << endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            const Measurement& m = results[i];
+            cout << "  {\"scenario\": \"" << m.scenario << "\", \"items\": " << m.items
+                 << ", \"seconds\": " << m.seconds << ", \"items_per_second\": " << (size_t)perSecond(m)
+                 << ", \"ns_per_item\": " << nsPerItem(m) << ", \"allocations\": " << m.allocations
+                 << ", \"allocated_bytes\": " << m.bytes << ", \"failed\": " << m.failures << "}"
+                 << (i + 1 < results.size() ? "," : "") << endl;
+        }
+        cout << "]}" << endl;
+        return;
+    }
+
+    cout << "scenario,items,seconds,items_per_second,ns_per_item,allocations,allocated_bytes,failed" << endl;
+    for (const Measurement& m : results) {
+        cout << m.scenario << "," << m.items << "," << m.seconds << "," << (size_t)perSecond(m) << ","
+             << nsPerItem(m) << "," << m.allocations << "," << m.bytes << "," << m.failures << endl;
+    }
+}
+
+// ==================== Scenarios ====================
+
+// Rents carId until returnDate and returns it straight away. A rent or
+// return the engine refuses is counted as a failure.
+bool rentAndReturn(RentalEngine& engine, int carId, const char* customer, const Date& returnDate) {
+    Result<Rental> rental = engine.rent(carId, customer, returnDate);
+    if (rental.ok() && engine.returnRental(rental.value.id).ok()) return true;
+    failureCount++;
+    return false;
+}
+
+// Number of cars holding two active rentals whose dates overlap, which
+// means the car was handed to two customers for the same days.
+size_t countDoubleBookings(vector<Rental> active) {
+    sort(active.begin(), active.end(), [](const Rental& a, const Rental& b) {
+        return a.carId != b.carId ? a.carId < b.carId : a.rentDate.serial < b.rentDate.serial;
+    });
+    size_t doubleBooked = 0;
+    for (size_t i = 1; i < active.size(); i++) {
+        if (active[i].carId == active[i - 1].carId && active[i].rentDate.serial <= active[i - 1].returnDate.serial) {
+            doubleBooked++;
+        }
+    }
+    return doubleBooked;
+}
+
+void runScenarios(const BenchConfig& config) {
+    mt19937 random(20240601);
+    measure("generate", [&] {
+        generateData(config, random);
+        return config.cars + config.rentals;
+    });
+
+    // Loading includes the save that folds the data back to disk
+    unique_ptr<RentalEngine> engine;
+    measure("cold_load_text", [&] {
+        engine.reset(new RentalEngine(config.directory, nullptr));
+        return engine->fleet().size() + engine->rentalCount();
+    });
+
+    // Same load with the rentals file parsed by a fixed number of threads
+    for (size_t threads : {1, 2, 4, 8}) {
+        engine.reset();
+        measure("load_text_threads_" + to_string(threads), [&] {
+            engine.reset(new RentalEngine(config.directory, nullptr, threads));
+            return engine->fleet().size() + engine->rentalCount();
+        });
+    }
+
+    measure("refresh_same_day", [&] {
+        for (size_t i = 0; i < config.ops; i++) {
+            engine->refresh();
+        }
+        return config.ops;
+    });
+
+    measure("lookup_car", [&] {
+        size_t found = 0;
+        for (size_t i = 0; i < config.ops; i++) {
+            found += engine->lookupCar(1 + random() % config.cars).ok();
+        }
+        return found;
+    });
+
+    measure("lookup_rental", [&] {
+        size_t found = 0;
+        for (size_t i = 0; i < config.ops; i++) {
+            found += engine->lookupRental(1 + random() % config.rentals).ok();
+        }
+        return found;
+    });
+
+    measure("history_page_50", [&] {
+        size_t rows = 0;
+        size_t amount = 0;
+        size_t pages = max<size_t>(1, config.ops / 50);
+        for (size_t i = 0; i < pages; i++) {
+            rows += engine->forEachHistory(random() % engine->rentalCount(), 50, [&](const Rental& rental) {
+                amount += rental.totalAmount;
+            });
+        }
+        return rows + (amount == 1);
+    });
+
+    measure("history_full", [&] {
+        size_t amount = 0;
+        size_t rows = engine->forEachHistory(0, engine->rentalCount(), [&](const Rental& rental) {
+            amount += rental.totalAmount;
+        });
+        return rows + (amount == 1); // keeps the walk from being optimized away
+    });
+
+    measure("available_cars_rent_range", [&] {
+        size_t rows = 0;
+        size_t queries = max<size_t>(1, config.ops / 1000);
+        for (size_t i = 0; i < queries; i++) {
+            int lo = 20 + random() % 400;
+            rows += engine->availableCars(lo, lo + 80).size();
+        }
+        return rows;
+    });
+
+    measure("search_cheapest_10_suvs", [&] {
+        FleetQuery query;
+        query.modelContains = "SUV";
+        query.availableOnly = true;
+        query.order = FleetQuery::Order::RentAscending;
+        query.limit = 10;
+        size_t queries = max<size_t>(1, config.ops / 100);
+        for (size_t i = 0; i < queries; i++) {
+            engine->findCars(query);
+        }
+        return queries;
+    });
+
+    Date today = getToday();
+    measure("free_cars_week", [&] {
+        size_t queries = max<size_t>(1, config.ops / 1000);
+        for (size_t i = 0; i < queries; i++) {
+            Date first = Date::fromSerial(today.serial + random() % 30);
+            engine->freeCars(first, Date::fromSerial(first.serial + 6));
+        }
+        return queries;
+    });
+
+    measure("calendar_365_days", [&] {
+        size_t queries = max<size_t>(1, config.ops / 10000);
+        for (size_t i = 0; i < queries; i++) {
+            engine->freeCarsPerDay(today, 365);
+        }
+        return queries;
+    });
+
+    measure("revenue_month", [&] {
+        int64_t revenue = 0;
+        for (size_t i = 0; i < config.ops; i++) {
+            Date first = Date::fromSerial(today.serial - random() % 1095);
+            revenue += engine->usageBetween(first, Date::fromSerial(first.serial + 30)).revenue;
+        }
+        return config.ops + (revenue == 1);
+    });
+
+    measure("customer_rentals", [&] {
+        size_t customers = max<size_t>(1, config.rentals / 10);
+        string name;
+        for (size_t i = 0; i < config.ops; i++) {
+            name = "Customer ";
+            appendInt(name, 1 + random() % customers);
+            engine->customerRentals(name);
+        }
+        return config.ops;
+    });
+
+    // Each transaction rents one of the cars that are neither out nor
+    // reserved and returns it, journaled with an fsync per change
+    size_t firstIdleCar = config.cars / 3 * 2 + 1;
+    auto idleCar = [&](mt19937& generator) {
+        return (int)(firstIdleCar + generator() % (config.cars - firstIdleCar + 1));
+    };
+    measure("rent_return_durable", [&] {
+        size_t done = 0;
+        for (size_t i = 0; i < config.transactions; i++) {
+            done += rentAndReturn(*engine, idleCar(random), "Bench customer", Date::fromSerial(today.serial + 3));
+        }
+        return done;
+    });
+
+    measure("rent_return_batched", [&] {
+        size_t done = 0;
+        engine->beginBatch();
+        for (size_t i = 0; i < config.transactions * 10; i++) {
+            done += rentAndReturn(*engine, idleCar(random), "Bench customer", Date::fromSerial(today.serial + 3));
+        }
+        engine->commitBatch();
+        return done;
+    });
+
+    measure("rent_return_write_back", [&] {
+        size_t done = 0;
+        engine->setWriteBackInterval(chrono::milliseconds(50));
+        for (size_t i = 0; i < config.transactions * 10; i++) {
+            done += rentAndReturn(*engine, idleCar(random), "Bench customer", Date::fromSerial(today.serial + 3));
+        }
+        engine->setWriteBackInterval(chrono::milliseconds(0));
+        return done;
+    });
+
+    // Desks compete for the same idle cars, so some rents are refused
+    // because another desk holds the car; those show up as failures. A
+    // watcher checks throughout that no car is ever booked twice.
+    vector<size_t> deskCounts;
+    for (size_t threads = 1; threads < config.threads; threads *= 2) {
+        deskCounts.push_back(threads);
+    }
+    deskCounts.push_back(config.threads);
+    for (size_t threads : deskCounts) {
+        measure("rent_return_threads_" + to_string(threads), [&] {
+            atomic<size_t> done(0);
+            atomic<bool> running(true);
+            size_t doubleBooked = 0;
+            thread watcher([&] {
+                while (running.load()) {
+                    doubleBooked = max(doubleBooked, countDoubleBookings(engine->activeRentalsSnapshot()));
+                    this_thread::sleep_for(chrono::milliseconds(1));
+                }
+            });
+            vector<thread> desks;
+            for (size_t t = 0; t < threads; t++) {
+                desks.emplace_back([&, t] {
+                    mt19937 deskRandom(t + 1);
+                    for (size_t i = 0; i < config.transactions / threads; i++) {
+                        done += rentAndReturn(*engine, idleCar(deskRandom), "Desk customer",
+                                              Date::fromSerial(today.serial + 3));
+                    }
+                });
+            }
+            for (auto& desk : desks) {
+                desk.join();
+            }
+            running = false;
+            watcher.join();
+            doubleBooked = max(doubleBooked, countDoubleBookings(engine->activeRentalsSnapshot()));
+            if (doubleBooked) {
+                cerr << "Error: " << doubleBooked << " cars had overlapping active rentals with "
+                     << threads << " desks." << endl;
+                invariantBroken = true;
+            }
+            return done.load();
+        });
+    }
+
+    measure("save_text", [&] {
+        engine->save();
+        return engine->fleet().size() + engine->rentalCount();
+    });
+
+    measure("convert_to_binary", [&] {
+        engine->convertStorage(true);
+        return engine->fleet().size() + engine->rentalCount();
+    });
+    engine.reset();
+
+    measure("cold_load_binary", [&] {
+        engine.reset(new RentalEngine(config.directory, nullptr));
+        return engine->fleet().size() + engine->rentalCount();
+    });
+
+    // A fresh engine has nothing to save until something changes
+    engine->rent(idleCar(random), "Bench customer", Date::fromSerial(today.serial + 3));
+    measure("save_binary", [&] {
+        engine->save();
+        return engine->fleet().size() + engine->rentalCount();
+    });
+
+    measure("save_unchanged", [&] {
+        engine->save();
+        return engine->fleet().size() + engine->rentalCount();
+    });
+
+    // Every rental out today ends within ten days, so the pass frees all
+    // of them and starts the reservations due by then. Runs last, since
+    // the engine then keeps that day until the clock catches up.
+    size_t activeBefore = engine->activeRentals().size();
+    measure("refresh_expire", [&] {
+        engine->refreshAsOf(Date::fromSerial(today.serial + 11));
+        return activeBefore - engine->activeRentals().size();
+    });
+    engine.reset();
+}
+
+// ==================== Main Function ====================
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << option << endl;
+            return 1;
+        }
+        string value = argv[++i];
+        if (option == "--cars") config.cars = max(3L, atol(value.c_str()));
+        else if (option == "--rentals") config.rentals = max(1L, atol(value.c_str()));
+        else if (option == "--ops") config.ops = max(1L, atol(value.c_str()));
+        else if (option == "--transactions") config.transactions = max(1L, atol(value.c_str()));
+        else if (option == "--threads") config.threads = max(1L, atol(value.c_str()));
+        else if (option == "--format" && (value == "csv" || value == "json")) config.format = value;
+        else if (option == "--dir") config.directory = value;
+        else {
+            cerr << "Usage: " << argv[0] << " [--cars N] [--rentals N] [--ops N] [--transactions N]"
+                 << " [--threads N] [--format csv|json] [--dir path]" << endl;
+            return 1;
+        }
+    }
+
+    bool temporary = config.directory.empty();
+    if (temporary) {
+        string pattern = (filesystem::temp_directory_path() / "rental_bench.XXXXXX").string();
+        if (!mkdtemp(pattern.data())) {
+            cerr << "Could not create a temporary directory." << endl;
+            return 1;
+        }
+        config.directory = pattern;
+    } else {
+        filesystem::create_directories(config.directory);
+        for (const char* name : {"cars_data.txt", "rentals_data.txt", "journal.txt",
+                                 "data_snapshot.bin"}) {
+            filesystem::remove(filesystem::path(config.directory) / name);
+        }
+    }
+
+    runScenarios(config);
+    printResults(config);
+
+    if (temporary) {
+        filesystem::remove_all(config.directory);
+    }
+    return invariantBroken ? 1 : 0;
+}
@@ -0,0 +1,1883 @@
+#include "rental_engine.h"
+
+#include <algorithm>
+#include <fstream>
+#include <charconv>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define FLEET_HAVE_AVX2 1
+#endif
+
+// ==================== Date Structure and Functions ====================
+
+Date getToday() {
+    time_t now = time(0);
+    tm localtm;
+    localtime_r(&now, &localtm); // localtime is not safe across threads
+    return Date(localtm.tm_mday, localtm.tm_mon + 1, localtm.tm_year + 1900);
+}
+
+// ==================== Text Parsing Helpers ====================
+
+bool nextField(string_view& rest, string_view& field) {
+    if (rest.data() == nullptr) return false;
+    size_t pos = rest.find('|');
+    if (pos == string_view::npos) {
+        field = rest;
+        rest = string_view();
+    } else {
+        field = rest.substr(0, pos);
+        rest.remove_prefix(pos + 1);
+    }
+    return true;
+}
+
+bool parseInt(string_view text, int& value) {
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    while (!text.empty() && text.back() == ' ') text.remove_suffix(1);
+    const char* end = text.data() + text.size();
+    auto result = from_chars(text.data(), end, value);
+    return result.ec == errc() && result.ptr == end && !text.empty();
+}
+
+bool parseFlag(string_view text, bool& value) {
+    if (text == "1") value = true;
+    else if (text == "0") value = false;
+    else return false;
+    return true;
+}
+
+void appendInt(string& out, int64_t value) {
+    char digits[24];
+    auto result = to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr - digits);
+}
+
+void Date::appendTo(string& out) const {
+    int d, m, y;
+    civilFromDays(serial, d, m, y);
+    appendInt(out, d);
+    out += ' ';
+    appendInt(out, m);
+    out += ' ';
+    appendInt(out, y);
+}
+
+bool Date::parse(string_view text, Date& date) {
+    int parts[3];
+    for (int i = 0; i < 3; i++) {
+        while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+        size_t end = text.find(' ');
+        if (end == string_view::npos) end = text.size();
+        if (!parseInt(text.substr(0, end), parts[i])) return false;
+        text.remove_prefix(end);
+    }
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    if (!text.empty()) return false;
+    
+    if (!Date::isValid(parts[0], parts[1], parts[2])) return false;
+    date = Date(parts[0], parts[1], parts[2]);
+    return true;
+}
+
+// Reads a whole file into memory so the loaders can parse it in one pass.
+bool readWholeFile(const string& path, string& contents) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    
+    file.seekg(0, ios::end);
+    streamoff size = file.tellg();
+    file.seekg(0, ios::beg);
+    contents.resize(size > 0 ? (size_t)size : 0);
+    if (size > 0) {
+        file.read(&contents[0], size);
+        contents.resize(file.gcount());
+    }
+    return true;
+}
+
+// Bad rows found while loading a data file, reported instead of aborting.
+struct ParseReport {
+    size_t badRows = 0;
+    vector<pair<size_t, const char*>> samples; // line number, reason
+    
+    static const size_t MAX_SAMPLES = 10;
+    
+    void add(size_t lineNumber, const char* reason) {
+        badRows++;
+        if (samples.size() < MAX_SAMPLES) {
+            samples.push_back({lineNumber, reason});
+        }
+    }
+    
+    // Folds in the report of a chunk that started lineOffset lines into
+    // the file.
+    void merge(const ParseReport& other, size_t lineOffset) {
+        for (const auto& sample : other.samples) {
+            if (samples.size() >= MAX_SAMPLES) break;
+            samples.push_back({sample.first + lineOffset, sample.second});
+        }
+        badRows += other.badRows;
+    }
+    
+    void print(ostream& out, const string& fileName) const {
+        if (badRows == 0) return;
+        out << "Warning: Skipped " << badRows << " bad row(s) in " << fileName << ":" << endl;
+        for (const auto& sample : samples) {
+            out << "  line " << sample.first << ": " << sample.second << endl;
+        }
+        if (badRows > samples.size()) {
+            out << "  ... and " << (badRows - samples.size()) << " more" << endl;
+        }
+    }
+};
+
+// Calls handler(line, lineNumber) for every non-empty line of the buffer
+// and returns the number of lines seen.
+template <typename Handler>
+size_t forEachLine(string_view buffer, Handler handler) {
+    size_t lineNumber = 0;
+    while (!buffer.empty()) {
+        size_t end = buffer.find('\n');
+        string_view line = buffer.substr(0, end);
+        buffer.remove_prefix(end == string_view::npos ? buffer.size() : end + 1);
+        lineNumber++;
+        
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (!line.empty()) {
+            handler(line, lineNumber);
+        }
+    }
+    return lineNumber;
+}
+
+// Splits buffer into at most count pieces that each end on a newline.
+vector<string_view> splitIntoLineChunks(string_view buffer, size_t count) {
+    vector<string_view> chunks;
+    size_t target = buffer.size() / max<size_t>(count, 1) + 1;
+    while (!buffer.empty()) {
+        size_t end = buffer.size();
+        if (chunks.size() + 1 < count && target < buffer.size()) {
+            end = buffer.find('\n', target);
+            end = (end == string_view::npos) ? buffer.size() : end + 1;
+        }
+        chunks.push_back(buffer.substr(0, end));
+        buffer.remove_prefix(end);
+    }
+    return chunks;
+}
+
+// ==================== Atomic File Writes ====================
+
+// Writes a data file under a temporary name next to it, then syncs it
+// and renames it over the old file, so a crash leaves either the old or
+// the new contents but never a torn mix. Dropped without commit(), the
+// old file is left alone.
+class AtomicFile {
+private:
+    string path;
+    string tempPath;
+    int fd;
+    bool failed;
+    
+    // Makes the rename itself durable.
+    void syncDirectory() {
+        size_t slash = path.rfind('/');
+        string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        int dirFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+    }
+    
+public:
+    explicit AtomicFile(const string& path) : path(path), tempPath(path + ".tmp"), failed(false) {
+        fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    
+    ~AtomicFile() {
+        if (fd >= 0) {
+            close(fd);
+            unlink(tempPath.c_str());
+        }
+    }
+    
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+    
+    bool isOpen() const { return fd >= 0; }
+    
+    void write(const char* data, size_t size) {
+        while (!failed && size > 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno != EINTR) failed = true;
+                continue;
+            }
+            data += n;
+            size -= n;
+        }
+    }
+    
+    // Returns false, keeping the old file, if anything failed.
+    bool commit() {
+        bool ok = !failed && fsync(fd) == 0;
+        ok = close(fd) == 0 && ok;
+        fd = -1;
+        if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+            unlink(tempPath.c_str());
+            return false;
+        }
+        syncDirectory();
+        return true;
+    }
+};
+
+// ==================== Symbol Table ====================
+
+SymbolTable& symbols() {
+    static SymbolTable table;
+    return table;
+}
+
+// ==================== Fleet Table ====================
+
+// Bit j of the result is set when lo <= rents[j] <= hi, for j < count <= 64.
+inline uint64_t rentRangeMaskPortable(const int* rents, size_t count, int lo, int hi) {
+    uint64_t mask = 0;
+    for (size_t j = 0; j < count; j++) {
+        mask |= (uint64_t)(rents[j] >= lo && rents[j] <= hi) << j;
+    }
+    return mask;
+}
+
+#ifdef FLEET_HAVE_AVX2
+__attribute__((target("avx2")))
+inline uint64_t rentRangeMaskAvx2(const int* rents, size_t count, int lo, int hi) {
+    const __m256i low = _mm256_set1_epi32(lo);
+    const __m256i high = _mm256_set1_epi32(hi);
+    uint64_t mask = 0;
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rents + j));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(low, values),
+                                          _mm256_cmpgt_epi32(values, high));
+        uint64_t lanes = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(outside));
+        mask |= (~lanes & 0xFF) << j;
+    }
+    return mask | (rentRangeMaskPortable(rents + j, count - j, lo, hi) << j);
+}
+#endif
+
+uint64_t FleetTable::rentRangeMask(size_t first, size_t count, int lo, int hi) const {
+#ifdef FLEET_HAVE_AVX2
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) return rentRangeMaskAvx2(rents.data() + first, count, lo, hi);
+#endif
+    return rentRangeMaskPortable(rents.data() + first, count, lo, hi);
+}
+
+// Ids of available cars with lo <= dailyRent <= hi, in slot order.
+vector<int> FleetTable::filterAvailable(int lo, int hi) const {
+    vector<int> result;
+    for (size_t block = 0; block < availableBits.size(); block++) {
+        uint64_t matches = availableBits[block].load(memory_order_acquire);
+        if (matches == 0) continue;
+        
+        size_t first = block * 64;
+        matches &= rentRangeMask(first, min<size_t>(64, ids.size() - first), lo, hi);
+        while (matches) {
+            result.push_back(ids[first + __builtin_ctzll(matches)]);
+            matches &= matches - 1;
+        }
+    }
+    return result;
+}
+
+// Brings the rent order up to date. Needs at least the fleet read lock;
+// rentOrderLock keeps two readers from merging at once.
+const vector<uint32_t>& FleetTable::rentOrder() const {
+    lock_guard<mutex> lock(rentOrderLock);
+    size_t sorted = slotsByRent.size();
+    if (sorted < ids.size()) {
+        auto byRent = [&](uint32_t a, uint32_t b) {
+            return rents[a] != rents[b] ? rents[a] < rents[b] : a < b;
+        };
+        for (size_t slot = sorted; slot < ids.size(); slot++) {
+            slotsByRent.push_back(slot);
+        }
+        sort(slotsByRent.begin() + sorted, slotsByRent.end(), byRent);
+        inplace_merge(slotsByRent.begin(), slotsByRent.begin() + sorted, slotsByRent.end(), byRent);
+    }
+    return slotsByRent;
+}
+
+static bool containsIgnoringCase(string_view text, string_view part) {
+    auto found = search(text.begin(), text.end(), part.begin(), part.end(), [](char a, char b) {
+        return tolower((unsigned char)a) == tolower((unsigned char)b);
+    });
+    return found != text.end() || part.empty();
+}
+
+vector<int> FleetTable::select(const FleetQuery& query, FleetQueryPlan* plan) const {
+    FleetQueryPlan chosen;
+    vector<uint32_t> slots;
+    bool rentOrdered = query.order != FleetQuery::Order::Fleet;
+    
+    Symbol company = 0;
+    const vector<uint32_t>* companySlots = nullptr;
+    if (!query.company.empty()) {
+        auto found = symbols().find(query.company, company) ? slotsByCompany.find(company) : slotsByCompany.end();
+        if (found == slotsByCompany.end()) {
+            if (plan) *plan = chosen;
+            return vector<int>();
+        }
+        companySlots = &found->second;
+    }
+    
+    // Stops early once limit matches are in when the candidates already
+    // come in the requested order
+    auto collect = [&](size_t slot, bool ordered) {
+        chosen.examined++;
+        if (rents[slot] < query.minRent || rents[slot] > query.maxRent) return true;
+        if (query.availableOnly && !isAvailable(slot)) return true;
+        if (companySlots && companies[slot] != company) return true;
+        if (!containsIgnoringCase(model(slot), query.modelContains)) return true;
+        slots.push_back(slot);
+        return !(ordered && query.limit > 0 && slots.size() >= query.limit);
+    };
+    
+    // Estimate how many cars each plan looks at
+    const vector<uint32_t>& byRent = rentOrder();
+    auto first = lower_bound(byRent.begin(), byRent.end(), query.minRent,
+                             [&](uint32_t slot, int rent) { return rents[slot] < rent; });
+    auto last = upper_bound(first, byRent.end(), query.maxRent,
+                            [&](int rent, uint32_t slot) { return rent < rents[slot]; });
+    
+    double total = max<size_t>(ids.size(), 1);
+    double share = 1.0; // rough share of cars passing the filters other than rent
+    if (companySlots) share *= companySlots->size() / total;
+    if (query.availableOnly) share *= countAvailable() / total;
+    
+    double rentCost = last - first;
+    if (rentOrdered && query.limit > 0 && share > 0) {
+        rentCost = min(rentCost, query.limit / share);
+    }
+    double companyCost = companySlots ? companySlots->size() : numeric_limits<double>::infinity();
+    double scanCost = ids.size();
+    
+    if (companyCost <= rentCost && companyCost <= scanCost) {
+        chosen.index = "company index";
+        for (uint32_t slot : *companySlots) {
+            if (!collect(slot, !rentOrdered)) break;
+        }
+    } else if (rentCost <= scanCost) {
+        chosen.index = "rent index";
+        if (query.order == FleetQuery::Order::RentDescending) {
+            for (auto it = last; it != first && collect(*(it - 1), true); --it) {}
+        } else {
+            for (auto it = first; it != last && collect(*it, rentOrdered); ++it) {}
+        }
+        if (!rentOrdered) {
+            sort(slots.begin(), slots.end());
+        }
+    } else {
+        chosen.index = "full scan";
+        // Whole words of rented cars are skipped when only available ones count
+        bool more = true;
+        for (size_t block = 0; more && block < availableBits.size(); block++) {
+            uint64_t candidates = query.availableOnly ? availableBits[block].load(memory_order_acquire) : ~(uint64_t)0;
+            size_t base = block * 64;
+            candidates &= rentRangeMask(base, min<size_t>(64, ids.size() - base), query.minRent, query.maxRent);
+            while (more && candidates) {
+                more = collect(base + __builtin_ctzll(candidates), !rentOrdered);
+                candidates &= candidates - 1;
+            }
+        }
+    }
+    
+    size_t count = query.limit > 0 ? min(query.limit, slots.size()) : slots.size();
+    if (rentOrdered && chosen.index != string_view("rent index")) {
+        bool ascending = query.order == FleetQuery::Order::RentAscending;
+        partial_sort(slots.begin(), slots.begin() + count, slots.end(), [&](uint32_t a, uint32_t b) {
+            if (rents[a] != rents[b]) return ascending ? rents[a] < rents[b] : rents[a] > rents[b];
+            return ascending ? a < b : a > b;
+        });
+    }
+    
+    vector<int> result(count);
+    for (size_t i = 0; i < count; i++) {
+        result[i] = ids[slots[i]];
+    }
+    if (plan) *plan = chosen;
+    return result;
+}
+
+vector<uint64_t> FleetTable::companyMask(string_view company) const {
+    vector<uint64_t> mask((ids.size() + 63) / 64, 0);
+    if (company.empty()) {
+        for (size_t slot = 0; slot < ids.size(); slot++) {
+            mask[slot / 64] |= (uint64_t)1 << (slot % 64);
+        }
+        return mask;
+    }
+    if (const vector<uint32_t>* slots = companySlots(company)) {
+        for (uint32_t slot : *slots) {
+            mask[slot / 64] |= (uint64_t)1 << (slot % 64);
+        }
+    }
+    return mask;
+}
+
+// ==================== Binary Snapshot Format ====================
+
+// Layout of data_snapshot.bin:
+//   SnapshotHeader
+//   SnapshotCar[carCount]
+//   SnapshotRental[rentalCount]
+//   string pool (poolSize bytes, referenced by offset/length)
+// All fields are little-endian fixed width so the file can be mapped and
+// read in place.
+
+const char SNAPSHOT_MAGIC[8] = {'C', 'R', 'S', 'N', 'A', 'P', '\0', '\0'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t carCount;
+    uint32_t rentalCount;
+    uint32_t poolSize;
+    int32_t nextCarId;
+    int32_t nextRentalId;
+};
+
+struct SnapshotCar {
+    int32_t id;
+    uint32_t companyOffset;
+    uint32_t companyLength;
+    uint32_t modelOffset;
+    uint32_t modelLength;
+    int32_t dailyRent;
+    uint8_t isAvailable;
+    uint8_t padding[3];
+};
+
+struct SnapshotDate {
+    uint8_t day;
+    uint8_t month;
+    uint16_t year;
+};
+
+struct SnapshotRental {
+    int32_t id;
+    int32_t carId;
+    uint32_t customerOffset;
+    uint32_t customerLength;
+    SnapshotDate rentDate;
+    SnapshotDate returnDate;
+    int32_t totalAmount;
+    uint8_t isActive;
+    uint8_t padding;
+    int16_t returnedOffset; // returnedOn - returnDate; 0 in older snapshots
+};
+
+static_assert(sizeof(SnapshotHeader) == 32, "snapshot header layout changed");
+static_assert(sizeof(SnapshotCar) == 28, "snapshot car layout changed");
+static_assert(sizeof(SnapshotRental) == 32, "snapshot rental layout changed");
+
+// Each distinct name goes into the pool once; offsets are remembered
+// per symbol.
+static uint32_t addToPool(string& pool, vector<uint32_t>& offsets, Symbol symbol) {
+    if (offsets[symbol] == UINT32_MAX) {
+        offsets[symbol] = pool.size();
+        pool += symbols().name(symbol);
+    }
+    return offsets[symbol];
+}
+
+static SnapshotDate packDate(const Date& date) {
+    int d, m, y;
+    Date::civilFromDays(date.serial, d, m, y);
+    SnapshotDate packed;
+    packed.day = d;
+    packed.month = m;
+    packed.year = y;
+    return packed;
+}
+
+static Date unpackDate(const SnapshotDate& packed) {
+    return Date(packed.day, packed.month, packed.year);
+}
+
+template <typename Slot>
+static void setSlot(vector<Slot>& slots, int id, const Slot& slot, const Slot& empty) {
+    if (id < 0) return;
+    if ((size_t)id >= slots.size()) {
+        slots.resize(id + 1, empty);
+    }
+    slots[id] = slot;
+}
+
+// ==================== Engine Statistics ====================
+
+const char* statName(StatTimer timer) {
+    switch (timer) {
+        case StatTimer::Load: return "load";
+        case StatTimer::Save: return "save";
+        case StatTimer::SnapshotWrite: return "snapshot write";
+        case StatTimer::JournalWrite: return "journal write";
+        case StatTimer::Rent: return "rent";
+        case StatTimer::Reserve: return "reserve";
+        case StatTimer::Return: return "return";
+        case StatTimer::Refresh: return "refresh";
+        case StatTimer::ListAvailable: return "list available";
+        case StatTimer::ListRented: return "list rented";
+        case StatTimer::History: return "history";
+        case StatTimer::FindCars: return "find cars";
+        case StatTimer::FreeCars: return "free cars";
+        case StatTimer::Calendar: return "calendar";
+        case StatTimer::Count: break;
+    }
+    return "unknown";
+}
+
+const char* statName(StatCounter counter) {
+    switch (counter) {
+        case StatCounter::CarsParsed: return "cars parsed";
+        case StatCounter::RentalsParsed: return "rentals parsed";
+        case StatCounter::JournalReplayed: return "journal records replayed";
+        case StatCounter::DataBytesWritten: return "data bytes written";
+        case StatCounter::JournalBytesWritten: return "journal bytes written";
+        case StatCounter::JournalSyncs: return "journal fsyncs";
+        case StatCounter::CarLookups: return "car lookups";
+        case StatCounter::RentalLookups: return "rental lookups";
+        case StatCounter::RowsListed: return "rows listed";
+        case StatCounter::Count: break;
+    }
+    return "unknown";
+}
+
+uint64_t LatencyHistogram::bucketLimit(int bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    int shift = (bucket >> SUB_BITS) - 1;
+    uint64_t lower = (uint64_t)(SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = max<uint64_t>(1, (uint64_t)(fraction * n + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i].load(memory_order_relaxed);
+        if (seen >= rank) return min(bucketLimit(i), maximum());
+    }
+    return maximum();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : counts) {
+        bucket.store(0, memory_order_relaxed);
+    }
+    samples.store(0, memory_order_relaxed);
+    totalNanos.store(0, memory_order_relaxed);
+    maxNanos.store(0, memory_order_relaxed);
+}
+
+void EngineStats::reset() {
+    for (auto& timer : timers) {
+        timer.reset();
+    }
+    for (auto& counter : counters) {
+        counter.value.store(0, memory_order_relaxed);
+    }
+}
+
+// ==================== Rental Engine ====================
+
+const char* describeStatus(RentalStatus status) {
+    switch (status) {
+        case RentalStatus::Ok: return "ok";
+        case RentalStatus::InvalidAmount: return "Invalid amount. Please enter a positive number.";
+        case RentalStatus::CarNotFound: return "Car ID not found!";
+        case RentalStatus::CarNotAvailable: return "Car is already rented!";
+        case RentalStatus::CarBooked: return "Car is already booked for those dates!";
+        case RentalStatus::StartDateInPast: return "Start date cannot be in the past!";
+        case RentalStatus::StartDateTooFar: return "Reservations can start at most 1 year ahead!";
+        case RentalStatus::ReturnDateNotInFuture: return "Return date must be in the future!";
+        case RentalStatus::ReturnBeforeStart: return "Return date must be after the start date!";
+        case RentalStatus::RentalTooLong: return "Maximum rental period is 1 year!";
+        case RentalStatus::RentalNotFound: return "Rental ID not found!";
+        case RentalStatus::AlreadyReturned: return "This car has already been returned.";
+        case RentalStatus::IdsExhausted: return "No more ids are available!";
+    }
+    return "unknown error";
+}
+
+static string dataPath(const string& directory, const string& name) {
+    if (directory.empty() || directory.back() == '/') return directory + name;
+    return directory + "/" + name;
+}
+
+RentalEngine::RentalEngine(const string& dataDirectory, ostream* log, size_t loadThreads)
+    : nextCarId(1), nextRentalId(1),
+      lastAvailabilityCheck(numeric_limits<int32_t>::min()),
+      CARS_FILE(dataPath(dataDirectory, "cars_data.txt")),
+      RENTALS_FILE(dataPath(dataDirectory, "rentals_data.txt")),
+      LEGACY_ID_FILE(dataPath(dataDirectory, "id_counter.txt")), legacyIdFile(false),
+      JOURNAL_FILE(dataPath(dataDirectory, "journal.txt")),
+      SNAPSHOT_FILE(dataPath(dataDirectory, "data_snapshot.bin")),
+      logStream(log), journalFd(-1), journalRecords(0), journalSize(0),
+      pendingRecords(0), journalQueued(0), journalDurable(0),
+      journalFlushing(false), batching(false), binarySnapshot(false),
+      carsDirty(false), rentalsDirty(false),
+      writeBackInterval(0), writeBackStopping(false) {
+    loadAllData(loadThreads); // Load data from files on startup
+}
+
+RentalEngine::~RentalEngine() {
+    stopWriteBack();
+    save(); // Save data to files on exit
+    if (journalFd >= 0) {
+        close(journalFd);
+    }
+}
+
+ostream& RentalEngine::log() {
+    static ostream discard(nullptr);
+    return logStream ? *logStream : discard;
+}
+
+void RentalEngine::indexRental(bool active, size_t slot) {
+    const Rental& rental = active ? activeTable[slot] : archiveTable[slot];
+    setSlot(rentalSlots, rental.id, RentalSlot{(int)slot, active}, RentalSlot());
+}
+
+void RentalEngine::rebuildIndexes() {
+    rentalSlots.assign(nextRentalId, RentalSlot());
+    for (size_t i = 0; i < archiveTable.size(); i++) {
+        indexRental(false, i);
+    }
+    for (size_t i = 0; i < activeTable.size(); i++) {
+        indexRental(true, i);
+    }
+}
+
+// Adds a rental to the table matching its isActive flag.
+void RentalEngine::storeRental(Rental rental) {
+    vector<Rental>& table = rental.isActive ? activeTable : archiveTable;
+    table.push_back(move(rental));
+    indexRental(table.back().isActive, table.size() - 1);
+}
+
+// Splits freshly loaded rentals between the active table and the archive.
+void RentalEngine::storeLoadedRentals(vector<Rental>& loaded) {
+    activeTable.clear();
+    archiveTable.clear();
+    
+    size_t activeCount = 0;
+    for (const auto& rental : loaded) {
+        activeCount += rental.isActive;
+    }
+    
+    if (activeCount == 0) {
+        archiveTable.swap(loaded);
+        return;
+    }
+    
+    activeTable.reserve(activeCount);
+    archiveTable.reserve(loaded.size() - activeCount);
+    for (auto& rental : loaded) {
+        (rental.isActive ? activeTable : archiveTable).push_back(move(rental));
+    }
+    loaded.clear();
+}
+
+// Moves an active rental into the archive once it has been returned or
+// has expired. Pointers to the rental are invalidated.
+Rental* RentalEngine::archiveRental(int rentalId) {
+    RentalSlot location = rentalSlots[rentalId];
+    if (!location.active) return &archiveTable[location.slot];
+    
+    const Rental& rental = activeTable[location.slot];
+    int carSlot = findCar(rental.carId);
+    if (carSlot >= 0) {
+        bookings.remove(carSlot, rentalId);
+        calendar.release(carSlot, rental.rentDate.serial, rental.returnDate.serial);
+    }
+    archiveTable.push_back(move(activeTable[location.slot]));
+    archiveTable.back().isActive = false;
+    indexRental(false, archiveTable.size() - 1);
+    
+    // Fill the hole with the last active rental
+    if ((size_t)location.slot + 1 != activeTable.size()) {
+        activeTable[location.slot] = move(activeTable.back());
+        indexRental(true, location.slot);
+    }
+    activeTable.pop_back();
+    return &archiveTable.back();
+}
+
+const Rental* RentalEngine::findRental(int rentalId) const {
+    stats.add(StatCounter::RentalLookups);
+    if (rentalId < 0 || (size_t)rentalId >= rentalSlots.size()) return nullptr;
+    const RentalSlot& location = rentalSlots[rentalId];
+    if (location.slot < 0) return nullptr;
+    return location.active ? &activeTable[location.slot] : &archiveTable[location.slot];
+}
+
+Rental* RentalEngine::findRentalById(int rentalId) {
+    return const_cast<Rental*>(findRental(rentalId));
+}
+
+// Queues an active rental for expiry and, if it starts later, for the day
+// its car is taken.
+void RentalEngine::schedule(const Rental& rental, const Date& today) {
+    expiryQueue.push({rental.returnDate.serial, rental.id});
+    if (rental.rentDate > today) {
+        startQueue.push({rental.rentDate.serial, rental.id});
+    }
+}
+
+void RentalEngine::rebuildSchedule() {
+    Date today = getToday();
+    expiryQueue = DayQueue();
+    startQueue = DayQueue();
+    bookings.clear();
+    calendar.clear(today.serial);
+    for (const auto& rental : activeTable) {
+        schedule(rental, today);
+        int carSlot = findCar(rental.carId);
+        if (carSlot >= 0) {
+            bookings.add(carSlot, Booking{rental.rentDate.serial, rental.returnDate.serial, rental.id});
+            calendar.book(carSlot, rental.rentDate.serial, rental.returnDate.serial);
+        }
+    }
+    lastAvailabilityCheck = numeric_limits<int32_t>::min();
+}
+
+// Totals are only rebuilt from the whole history when loading.
+void RentalEngine::rebuildLedger() {
+    ledger.clear();
+    for (const auto* table : {&archiveTable, &activeTable}) {
+        for (const auto& rental : *table) {
+            int carSlot = findCar(rental.carId);
+            if (carSlot >= 0 && !rental.wasCancelled()) {
+                ledger.record(carSlot, carTable.companySymbol(carSlot), rental, 1);
+            }
+        }
+    }
+}
+
+// Walks rentals by id so each customer's list comes out in booking order.
+void RentalEngine::rebuildCustomers() {
+    customers.clear();
+    for (size_t id = 0; id < rentalSlots.size(); id++) {
+        const Rental* rental = findRental(id);
+        if (rental) {
+            customers.add(rental->customer, rental->id);
+        }
+    }
+}
+
+void RentalEngine::refresh() {
+    refreshAsOf(getToday());
+}
+
+// Only pops rentals whose return or start date has passed since the last
+// check, and does nothing at all if the day has not moved forward.
+void RentalEngine::refreshAsOf(const Date& today) {
+    if (today.serial <= lastAvailabilityCheck) return;
+    
+    ScopedTimer timer(stats, StatTimer::Refresh);
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    unique_lock<shared_mutex> rentalWrite(rentalLock);
+    if (today.serial <= lastAvailabilityCheck) return;
+    lastAvailabilityCheck = today.serial;
+    
+    // Free cars first, so a reservation starting the day after another
+    // rental ends takes the car back
+    while (!expiryQueue.empty() && expiryQueue.top().first < today.serial) {
+        int rentalId = expiryQueue.top().second;
+        expiryQueue.pop();
+        
+        Rental* rental = findRentalById(rentalId);
+        if (!rental || !rental->isActive) continue;
+        
+        int carId = rental->carId;
+        archiveRental(rentalId);
+        rentalsDirty = true;
+        int carSlot = findCar(carId);
+        if (carSlot >= 0) {
+            carTable.setAvailable(carSlot, true);
+            carsDirty = true;
+        }
+    }
+    
+    while (!startQueue.empty() && startQueue.top().first <= today.serial) {
+        int rentalId = startQueue.top().second;
+        startQueue.pop();
+        
+        Rental* rental = findRentalById(rentalId);
+        if (!rental || !rental->isActive) continue;
+        
+        int carSlot = findCar(rental->carId);
+        if (carSlot >= 0) {
+            carTable.setAvailable(carSlot, false);
+            carsDirty = true;
+        }
+    }
+    
+    calendar.advance(today.serial);
+}
+
+// ========== FILE HANDLING METHODS ==========
+
+// Replaces path with contents. what names the data in the warning.
+bool RentalEngine::writeDataFile(const string& path, const string& contents, const char* what) {
+    AtomicFile file(path);
+    if (file.isOpen()) {
+        file.write(contents.data(), contents.size());
+        if (file.commit()) {
+            stats.add(StatCounter::DataBytesWritten, contents.size());
+            return true;
+        }
+    }
+    log() << "Warning: Could not save " << what << "." << endl;
+    return false;
+}
+
+string RentalEngine::carsFileContents() const {
+    string buffer;
+    for (size_t i = 0; i < carTable.size(); i++) {
+        carTable.get(i).appendTo(buffer);
+        buffer += '\n';
+    }
+    return buffer;
+}
+
+void RentalEngine::loadCarsFromFile() {
+    string buffer;
+    if (!readWholeFile(CARS_FILE, buffer)) {
+        log() << "No existing cars data found. Starting fresh." << endl;
+        carsDirty = true;
+        return;
+    }
+    
+    carTable.clear();
+    carTable.reserve(count(buffer.begin(), buffer.end(), '\n') + 1);
+    ParseReport report;
+    Car car;
+    size_t lines = forEachLine(buffer, [&](string_view line, size_t lineNumber) {
+        const char* error;
+        if (!Car::parse(line, car, error)) {
+            report.add(lineNumber, error);
+            return;
+        }
+        carTable.add(car);
+        if (car.id >= nextCarId) {
+            nextCarId = car.id + 1;
+        }
+    });
+    stats.add(StatCounter::CarsParsed, lines);
+    report.print(log(), CARS_FILE);
+    log() << "Loaded " << carTable.size() << " cars from file." << endl;
+}
+
+string RentalEngine::rentalsFileContents() const {
+    string buffer;
+    buffer.reserve(rentalCount() * SAVE_BYTES_PER_RENTAL);
+    for (const auto* table : {&archiveTable, &activeTable}) {
+        for (const auto& rental : *table) {
+            rental.appendTo(buffer);
+            buffer += '\n';
+        }
+    }
+    return buffer;
+}
+
+// Parses one chunk of rentals_data.txt. Used by both the serial and
+// the parallel loader. Customer names are only collected here and
+// interned later by internCustomers() on a single thread, since parse()
+// runs on several threads at once.
+struct RentalChunk {
+    vector<Rental> rentals;
+    vector<string_view> customerNames; // views into the file buffer
+    ParseReport report;
+    size_t lines = 0;
+    int maxId = 0;
+    
+    void parse(string_view buffer) {
+        size_t expected = count(buffer.begin(), buffer.end(), '\n') + 1;
+        rentals.reserve(expected);
+        customerNames.reserve(expected);
+        lines = forEachLine(buffer, [&](string_view line, size_t lineNumber) {
+            rentals.emplace_back();
+            Rental& rental = rentals.back();
+            string_view customerName;
+            const char* error;
+            if (!Rental::parse(line, rental, customerName, error)) {
+                rentals.pop_back();
+                report.add(lineNumber, error);
+                return;
+            }
+            customerNames.push_back(customerName);
+            maxId = max(maxId, rental.id);
+        });
+    }
+    
+    void internCustomers() {
+        for (size_t i = 0; i < rentals.size(); i++) {
+            rentals[i].customer = symbols().intern(customerNames[i]);
+        }
+        customerNames.clear();
+    }
+};
+
+size_t RentalEngine::rentalLoadThreads(size_t bytes) const {
+    if (bytes < PARALLEL_LOAD_MIN_BYTES) return 1;
+    size_t threads = max(1u, thread::hardware_concurrency());
+    return min(threads, bytes / PARALLEL_LOAD_MIN_CHUNK);
+}
+
+void RentalEngine::loadRentalsFromFile(size_t threadCount) {
+    string buffer;
+    if (!readWholeFile(RENTALS_FILE, buffer)) {
+        log() << "No existing rentals data found. Starting fresh." << endl;
+        rentalsDirty = true;
+        return;
+    }
+    
+    if (threadCount == 0) {
+        threadCount = rentalLoadThreads(buffer.size());
+    }
+    
+    // Parse newline-aligned chunks side by side, then stitch them back
+    // together in file order.
+    vector<string_view> pieces = splitIntoLineChunks(buffer, threadCount);
+    vector<RentalChunk> chunks(pieces.size());
+    if (chunks.size() == 1) {
+        chunks[0].parse(pieces[0]);
+    } else {
+        vector<thread> workers;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            workers.emplace_back(&RentalChunk::parse, &chunks[i], pieces[i]);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    // Interned after the join, in file order, so symbols do not depend
+    // on how the workers were scheduled
+    size_t total = 0;
+    for (auto& chunk : chunks) {
+        chunk.internCustomers();
+        total += chunk.rentals.size();
+    }
+    
+    // A single chunk is taken over as is instead of being copied
+    vector<Rental> loaded;
+    if (chunks.size() == 1) {
+        loaded.swap(chunks[0].rentals);
+    } else {
+        loaded.reserve(total);
+    }
+    ParseReport report;
+    size_t lineOffset = 0;
+    for (auto& chunk : chunks) {
+        loaded.insert(loaded.end(),
+                       make_move_iterator(chunk.rentals.begin()),
+                       make_move_iterator(chunk.rentals.end()));
+        report.merge(chunk.report, lineOffset);
+        lineOffset += chunk.lines;
+        if (chunk.maxId >= nextRentalId) {
+            nextRentalId = chunk.maxId + 1;
+        }
+    }
+    
+    storeLoadedRentals(loaded);
+    stats.add(StatCounter::RentalsParsed, lineOffset);
+    
+    report.print(log(), RENTALS_FILE);
+    log() << "Loaded " << rentalCount() << " rentals from file";
+    if (chunks.size() > 1) {
+        log() << " using " << chunks.size() << " threads";
+    }
+    log() << "." << endl;
+}
+
+void RentalEngine::loadLegacyIdCounters() {
+    ifstream file(LEGACY_ID_FILE);
+    if (!file.is_open()) return;
+    
+    int carId = 1, rentalId = 1;
+    file >> carId >> rentalId;
+    // Counters past the id bounds can only come from a damaged file
+    if (carId <= MAX_CAR_ID) {
+        nextCarId = max(nextCarId.load(), carId);
+    }
+    if (rentalId <= MAX_RENTAL_ID) {
+        nextRentalId = max(nextRentalId.load(), rentalId);
+    }
+    legacyIdFile = true;
+}
+
+// ========== BINARY SNAPSHOT METHODS ==========
+
+string RentalEngine::binarySnapshotContents() const {
+    string pool;
+    vector<uint32_t> poolOffsets(symbols().size(), UINT32_MAX);
+    vector<SnapshotCar> carRecords(carTable.size());
+    vector<SnapshotRental> rentalRecords;
+    rentalRecords.reserve(rentalCount());
+    
+    for (size_t i = 0; i < carTable.size(); i++) {
+        SnapshotCar& record = carRecords[i];
+        memset(&record, 0, sizeof(record));
+        record.id = carTable.id(i);
+        record.companyOffset = addToPool(pool, poolOffsets, carTable.companySymbol(i));
+        record.companyLength = carTable.company(i).size();
+        record.modelOffset = addToPool(pool, poolOffsets, carTable.modelSymbol(i));
+        record.modelLength = carTable.model(i).size();
+        record.dailyRent = carTable.dailyRent(i);
+        record.isAvailable = carTable.isAvailable(i) ? 1 : 0;
+    }
+    
+    for (const auto* table : {&archiveTable, &activeTable}) {
+        for (const auto& rental : *table) {
+            SnapshotRental record;
+            memset(&record, 0, sizeof(record));
+            record.id = rental.id;
+            record.carId = rental.carId;
+            record.customerOffset = addToPool(pool, poolOffsets, rental.customer);
+            record.customerLength = rental.customerName().size();
+            record.rentDate = packDate(rental.rentDate);
+            record.returnDate = packDate(rental.returnDate);
+            record.totalAmount = rental.totalAmount;
+            record.isActive = rental.isActive ? 1 : 0;
+            record.returnedOffset = clamp<int>(rental.returnDate.differenceInDays(rental.returnedOn),
+                                               numeric_limits<int16_t>::min(), numeric_limits<int16_t>::max());
+            rentalRecords.push_back(record);
+        }
+    }
+    
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.carCount = carRecords.size();
+    header.rentalCount = rentalRecords.size();
+    header.poolSize = pool.size();
+    header.nextCarId = nextCarId;
+    header.nextRentalId = nextRentalId;
+    
+    string buffer;
+    buffer.reserve(sizeof(header) + carRecords.size() * sizeof(SnapshotCar) +
+                   rentalRecords.size() * sizeof(SnapshotRental) + pool.size());
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    buffer.append(reinterpret_cast<const char*>(carRecords.data()), carRecords.size() * sizeof(SnapshotCar));
+    buffer.append(reinterpret_cast<const char*>(rentalRecords.data()), rentalRecords.size() * sizeof(SnapshotRental));
+    buffer += pool;
+    return buffer;
+}
+
+bool RentalEngine::loadBinarySnapshot() {
+    int fd = open(SNAPSHOT_FILE.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        log() << "Warning: Snapshot file is truncated, ignoring it." << endl;
+        return false;
+    }
+    
+    size_t size = info.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        log() << "Warning: Could not map snapshot file." << endl;
+        return false;
+    }
+    
+    const char* base = static_cast<const char*>(mapped);
+    SnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+    
+    size_t expected = sizeof(SnapshotHeader) +
+                      (size_t)header.carCount * sizeof(SnapshotCar) +
+                      (size_t)header.rentalCount * sizeof(SnapshotRental) +
+                      header.poolSize;
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION || expected != size) {
+        munmap(mapped, size);
+        log() << "Warning: Snapshot file is not a supported format, ignoring it." << endl;
+        return false;
+    }
+    
+    const SnapshotCar* carRecords = reinterpret_cast<const SnapshotCar*>(base + sizeof(SnapshotHeader));
+    const SnapshotRental* rentalRecords = reinterpret_cast<const SnapshotRental*>(carRecords + header.carCount);
+    const char* pool = reinterpret_cast<const char*>(rentalRecords + header.rentalCount);
+    
+    bool idsInRange = header.nextCarId <= MAX_CAR_ID + 1 && header.nextRentalId <= MAX_RENTAL_ID + 1;
+    for (uint32_t i = 0; idsInRange && i < header.carCount; i++) {
+        idsInRange = carRecords[i].id >= 0 && carRecords[i].id <= MAX_CAR_ID;
+    }
+    for (uint32_t i = 0; idsInRange && i < header.rentalCount; i++) {
+        idsInRange = rentalRecords[i].id >= 0 && rentalRecords[i].id <= MAX_RENTAL_ID;
+    }
+    if (!idsInRange) {
+        munmap(mapped, size);
+        log() << "Warning: Snapshot file holds ids out of range, ignoring it." << endl;
+        return false;
+    }
+    
+    auto poolSymbol = [&](uint32_t offset, uint32_t length) {
+        if ((size_t)offset + length > header.poolSize) return Symbol(0);
+        return symbols().intern(string_view(pool + offset, length));
+    };
+    
+    carTable.clear();
+    carTable.reserve(header.carCount);
+    for (uint32_t i = 0; i < header.carCount; i++) {
+        const SnapshotCar& record = carRecords[i];
+        Car car(record.id,
+                poolSymbol(record.companyOffset, record.companyLength),
+                poolSymbol(record.modelOffset, record.modelLength),
+                record.dailyRent);
+        car.isAvailable = record.isAvailable != 0;
+        carTable.add(car);
+    }
+    
+    vector<Rental> loaded;
+    loaded.reserve(header.rentalCount);
+    for (uint32_t i = 0; i < header.rentalCount; i++) {
+        const SnapshotRental& record = rentalRecords[i];
+        Rental rental(record.id, record.carId,
+                      poolSymbol(record.customerOffset, record.customerLength),
+                      unpackDate(record.rentDate), unpackDate(record.returnDate),
+                      record.totalAmount);
+        rental.isActive = record.isActive != 0;
+        rental.returnedOn = Date::fromSerial(rental.returnDate.serial + record.returnedOffset);
+        loaded.push_back(rental);
+    }
+    storeLoadedRentals(loaded);
+    stats.add(StatCounter::CarsParsed, header.carCount);
+    stats.add(StatCounter::RentalsParsed, header.rentalCount);
+    
+    nextCarId = max(nextCarId.load(), (int)header.nextCarId);
+    nextRentalId = max(nextRentalId.load(), (int)header.nextRentalId);
+    
+    munmap(mapped, size);
+    log() << "Loaded " << carTable.size() << " cars and " << rentalCount()
+         << " rentals from snapshot." << endl;
+    return true;
+}
+
+// Serializes the tables that changed since the last save. Needs at
+// least the read locks; the image is written by writeSnapshot() once
+// they are released.
+RentalEngine::SnapshotImage RentalEngine::prepareSnapshot() {
+    SnapshotImage image;
+    image.cars = carsDirty.exchange(false);
+    image.rentals = rentalsDirty.exchange(false);
+    if (binarySnapshot) {
+        // Both tables share the one file
+        if (image.cars || image.rentals) {
+            image.cars = image.rentals = true;
+            image.binary = binarySnapshotContents();
+        }
+    } else {
+        if (image.cars) image.carsText = carsFileContents();
+        if (image.rentals) image.rentalsText = rentalsFileContents();
+    }
+    return image;
+}
+
+// Returns false if a file could not be written; its table is marked
+// dirty again for the next attempt.
+bool RentalEngine::writeSnapshot(const SnapshotImage& image) {
+    if (image.cars || image.rentals) {
+        ScopedTimer timer(stats, StatTimer::SnapshotWrite);
+        bool ok = true;
+        if (!image.binary.empty()) {
+            if (!writeDataFile(SNAPSHOT_FILE, image.binary, "snapshot file")) {
+                carsDirty = true;
+                rentalsDirty = true;
+                ok = false;
+            }
+        } else {
+            if (image.cars && !writeDataFile(CARS_FILE, image.carsText, "cars data to file")) {
+                carsDirty = true;
+                ok = false;
+            }
+            if (image.rentals && !writeDataFile(RENTALS_FILE, image.rentalsText, "rentals data to file")) {
+                rentalsDirty = true;
+                ok = false;
+            }
+        }
+        if (!ok) return false;
+    }
+    
+    if (legacyIdFile) {
+        remove(LEGACY_ID_FILE.c_str());
+        legacyIdFile = false;
+    }
+    return true;
+}
+
+// ========== JOURNAL METHODS ==========
+
+// Each record is one line: "C|<car>" or "R|<rental>" using the same
+// field layout as the data files. Replaying a record overwrites the
+// entry with the same id, or appends it if the id is new. Car
+// availability is not taken from the records but rebuilt from the
+// active rentals afterwards.
+void RentalEngine::openJournal() {
+    journalFd = open(JOURNAL_FILE.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (journalFd < 0) {
+        log() << "Warning: Could not open journal file." << endl;
+        return;
+    }
+    // Cut off a record torn by a crash, so new records start on a line
+    // of their own
+    if (ftruncate(journalFd, journalSize) != 0) {
+        log() << "Warning: Could not repair journal file." << endl;
+        close(journalFd);
+        journalFd = -1;
+    }
+}
+
+// Queues records behind everything queued before. Returns the ticket to
+// pass to awaitJournal once the caller's own locks are released, or 0
+// when the write-back thread or a batch commits the records later.
+uint64_t RentalEngine::queueJournal(const string& records, int count) {
+    lock_guard<mutex> lock(journalLock);
+    bool wasEmpty = pendingRecords == 0;
+    pendingJournal += records;
+    pendingRecords += count;
+    uint64_t ticket = ++journalQueued;
+    if (writeBackInterval.count() > 0) {
+        if (wasEmpty) writeBackWake.notify_one();
+        return 0;
+    }
+    return batching ? 0 : ticket;
+}
+
+void RentalEngine::awaitJournal(uint64_t ticket) {
+    if (ticket == 0) return;
+    unique_lock<mutex> lock(journalLock);
+    commitJournal(lock, ticket);
+}
+
+// Waits until the records queued up to ticket are on disk, running the
+// flush itself when no other thread is.
+void RentalEngine::commitJournal(unique_lock<mutex>& lock, uint64_t ticket) {
+    while (journalDurable < ticket) {
+        if (journalFlushing) {
+            journalFlushed.wait(lock);
+        } else {
+            flushJournal(lock, false);
+        }
+    }
+}
+
+// Called with journalLock held and no flush running. Writes the pending
+// records, then folds the journal into the data files when it has grown
+// past JOURNAL_COMPACT_RECORDS or compact is set.
+void RentalEngine::flushJournal(unique_lock<mutex>& lock, bool compact) {
+    journalFlushing = true;
+    string records;
+    records.swap(pendingJournal);
+    int count = pendingRecords;
+    pendingRecords = 0;
+    uint64_t covered = journalQueued;
+    lock.unlock();
+    
+    // Records that could not be journaled are made durable by folding
+    // the whole state into the data files right away
+    bool journaled = records.empty() || writeJournal(records);
+    if (journaled) {
+        journalRecords += count;
+    }
+    if (!journaled || compact || journalRecords >= JOURNAL_COMPACT_RECORDS) {
+        if (!compactJournal() && !journaled) {
+            log() << "Warning: Changes could not be saved and are only kept in memory "
+                  << "until the next successful save." << endl;
+        }
+    }
+    
+    lock.lock();
+    journalFlushing = false;
+    journalDurable = covered;
+    journalFlushed.notify_all();
+}
+
+// Appends records and syncs them. Returns false, leaving the journal as
+// it was, if they did not all reach the disk.
+bool RentalEngine::writeJournal(const string& records) {
+    if (journalFd < 0) return false;
+    
+    ScopedTimer timer(stats, StatTimer::JournalWrite);
+    size_t written = 0;
+    bool ok = true;
+    while (ok && written < records.size()) {
+        ssize_t n = write(journalFd, records.data() + written, records.size() - written);
+        if (n < 0) {
+            if (errno != EINTR) ok = false;
+            continue;
+        }
+        written += n;
+    }
+    ok = ok && fsync(journalFd) == 0;
+    stats.add(StatCounter::JournalSyncs);
+    
+    if (!ok) {
+        log() << "Warning: Could not write to journal file." << endl;
+        // A partial record in the middle would swallow the next one on
+        // replay. If it cannot be cut off, stop appending altogether.
+        if (ftruncate(journalFd, journalSize) != 0) {
+            close(journalFd);
+            journalFd = -1;
+        }
+        return false;
+    }
+    journalSize += written;
+    stats.add(StatCounter::JournalBytesWritten, written);
+    return true;
+}
+
+// Sleeps until records are queued, gives the rest of the burst one
+// interval to arrive, then writes them all with a single flush.
+void RentalEngine::writeBackLoop() {
+    unique_lock<mutex> lock(journalLock);
+    while (true) {
+        writeBackWake.wait(lock, [&] { return pendingRecords > 0 || writeBackStopping; });
+        writeBackWake.wait_for(lock, writeBackInterval, [&] { return writeBackStopping; });
+        journalFlushed.wait(lock, [&] { return !journalFlushing; });
+        if (pendingRecords > 0) {
+            flushJournal(lock, false);
+        }
+        if (writeBackStopping) break;
+    }
+}
+
+void RentalEngine::setWriteBackInterval(chrono::milliseconds interval) {
+    stopWriteBack();
+    if (interval.count() <= 0) return;
+    
+    lock_guard<mutex> lock(journalLock);
+    writeBackInterval = interval;
+    writeBackStopping = false;
+    writeBackThread = thread(&RentalEngine::writeBackLoop, this);
+}
+
+// Stops the write-back thread once it has written everything queued.
+// Operations from then on are durable before they return again.
+void RentalEngine::stopWriteBack() {
+    {
+        lock_guard<mutex> lock(journalLock);
+        if (!writeBackThread.joinable()) return;
+        writeBackStopping = true;
+    }
+    writeBackWake.notify_all();
+    writeBackThread.join();
+    
+    lock_guard<mutex> lock(journalLock);
+    writeBackInterval = chrono::milliseconds(0);
+}
+
+void RentalEngine::beginBatch() {
+    lock_guard<mutex> lock(journalLock);
+    batching = true;
+}
+
+void RentalEngine::commitBatch() {
+    unique_lock<mutex> lock(journalLock);
+    batching = false;
+    if (pendingRecords > 0) {
+        commitJournal(lock, journalQueued);
+    }
+}
+
+void RentalEngine::replayJournal() {
+    string contents;
+    if (!readWholeFile(JOURNAL_FILE, contents)) {
+        return;
+    }
+    
+    // A torn write can only leave a partial record at the very end, so
+    // anything after the last newline is ignored.
+    size_t complete = contents.rfind('\n');
+    string_view records(contents.data(), complete == string::npos ? 0 : complete + 1);
+    journalSize = records.size();
+    
+    ParseReport report;
+    forEachLine(records, [&](string_view line, size_t lineNumber) {
+        if (line.size() < 2 || line[1] != '|') {
+            report.add(lineNumber, "unknown record type");
+            return;
+        }
+        
+        const char* error;
+        if (line[0] == 'C') {
+            Car car;
+            if (!Car::parse(line.substr(2), car, error)) {
+                report.add(lineNumber, error);
+                return;
+            }
+            int existing = findCar(car.id);
+            if (existing >= 0) {
+                carTable.set(existing, car);
+            } else {
+                carTable.add(car);
+            }
+            carsDirty = true;
+            if (car.id >= nextCarId) {
+                nextCarId = car.id + 1;
+            }
+        } else if (line[0] == 'R') {
+            Rental rental;
+            if (!Rental::parse(line.substr(2), rental, error)) {
+                report.add(lineNumber, error);
+                return;
+            }
+            // A returned rental never becomes active again, so an active
+            // record met after its return is stale and skipped
+            Rental* existing = findRentalById(rental.id);
+            if (!existing) {
+                storeRental(rental);
+            } else if (existing->isActive || !rental.isActive) {
+                if (existing->isActive && !rental.isActive) {
+                    existing = archiveRental(rental.id);
+                }
+                bool active = existing->isActive;
+                *existing = rental;
+                existing->isActive = active;
+            }
+            rentalsDirty = true;
+            if (rental.id >= nextRentalId) {
+                nextRentalId = rental.id + 1;
+            }
+        } else {
+            report.add(lineNumber, "unknown record type");
+            return;
+        }
+        journalRecords++;
+    });
+    
+    stats.add(StatCounter::JournalReplayed, journalRecords);
+    report.print(log(), JOURNAL_FILE);
+    if (journalRecords > 0) {
+        log() << "Replayed " << journalRecords << " journal records." << endl;
+    }
+}
+
+// Folds the journal into the data files and starts a fresh journal. If
+// a data file could not be written the journal is kept, since it still
+// holds the only durable copy of those changes. Returns whether the data
+// files are up to date. The locks are only held to copy the tables, so
+// bookings go on while the files are written and synced.
+bool RentalEngine::compactJournal() {
+    SnapshotImage image;
+    {
+        shared_lock<shared_mutex> fleetRead(fleetLock);
+        shared_lock<shared_mutex> rentalRead(rentalLock);
+        image = prepareSnapshot();
+    }
+    if (!writeSnapshot(image)) return false;
+    
+    if (journalFd >= 0) {
+        if (journalSize > 0 && ftruncate(journalFd, 0) == 0) {
+            fsync(journalFd);
+            journalSize = 0;
+        }
+    } else {
+        // A journal that was given up on may hold stale records
+        remove(JOURNAL_FILE.c_str());
+    }
+    journalRecords = 0;
+    return true;
+}
+
+// ========== CORE OPERATIONS ==========
+
+// Checks a booking of carSlot from startDate to returnDate against the
+// rules and the booking index. Needs at least the rentals read lock.
+RentalStatus RentalEngine::checkBooking(int carSlot, const Date& today, const Date& startDate, const Date& returnDate) const {
+    if (carSlot < 0) return RentalStatus::CarNotFound;
+    if (startDate < today) return RentalStatus::StartDateInPast;
+    if (today.differenceInDays(startDate) > BOOKING_HORIZON_DAYS) return RentalStatus::StartDateTooFar;
+    if (startDate == today) {
+        if (!carTable.isAvailable(carSlot)) return RentalStatus::CarNotAvailable;
+        if (returnDate <= today) return RentalStatus::ReturnDateNotInFuture;
+    } else if (returnDate <= startDate) {
+        return RentalStatus::ReturnBeforeStart;
+    }
+    if (startDate.differenceInDays(returnDate) > MAX_RENTAL_DAYS) return RentalStatus::RentalTooLong;
+    if (!bookings.isFree(carSlot, startDate.serial, returnDate.serial)) return RentalStatus::CarBooked;
+    return RentalStatus::Ok;
+}
+
+Result<int> RentalEngine::addCar(string_view company, string_view model, int dailyRent) {
+    if (dailyRent <= 0) return RentalStatus::InvalidAmount;
+    
+    Car car(-1, symbols().intern(company), symbols().intern(model), dailyRent);
+    uint64_t ticket;
+    {
+        unique_lock<shared_mutex> fleetWrite(fleetLock);
+        if (nextCarId > MAX_CAR_ID) return RentalStatus::IdsExhausted;
+        car.id = nextCarId++;
+        carTable.add(car);
+        carsDirty = true;
+        ticket = queueJournal("C|" + car.toFileString() + "\n", 1);
+    }
+    awaitJournal(ticket);
+    return car.id;
+}
+
+Result<int> RentalEngine::quote(int carId, const Date& returnDate) const {
+    return quote(carId, getToday(), returnDate);
+}
+
+Result<int> RentalEngine::quote(int carId, const Date& startDate, const Date& returnDate) const {
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    int carSlot = findCar(carId);
+    RentalStatus status = checkBooking(carSlot, getToday(), startDate, returnDate);
+    if (status != RentalStatus::Ok) return status;
+    return startDate.differenceInDays(returnDate) * carTable.dailyRent(carSlot);
+}
+
+Result<Rental> RentalEngine::rent(int carId, string_view customer, const Date& returnDate) {
+    ScopedTimer timer(stats, StatTimer::Rent);
+    return book(carId, symbols().intern(customer), getToday(), returnDate);
+}
+
+Result<Rental> RentalEngine::reserve(int carId, string_view customer, const Date& startDate, const Date& returnDate) {
+    ScopedTimer timer(stats, StatTimer::Reserve);
+    return book(carId, symbols().intern(customer), startDate, returnDate);
+}
+
+Result<Rental> RentalEngine::book(int carId, Symbol customer, const Date& startDate, const Date& returnDate) {
+    Rental newRental;
+    uint64_t ticket;
+    {
+        shared_lock<shared_mutex> fleetRead(fleetLock);
+        unique_lock<shared_mutex> rentalWrite(rentalLock);
+        int carSlot = findCar(carId);
+        Date today = getToday();
+        RentalStatus status = checkBooking(carSlot, today, startDate, returnDate);
+        if (status != RentalStatus::Ok) return status;
+        if (nextRentalId > MAX_RENTAL_ID) return RentalStatus::IdsExhausted;
+        if (startDate == today) {
+            carTable.setAvailable(carSlot, false);
+            carsDirty = true;
+        }
+        
+        int rentalDays = startDate.differenceInDays(returnDate);
+        newRental = Rental(nextRentalId++, carId, customer, startDate, returnDate,
+                           rentalDays * carTable.dailyRent(carSlot));
+        storeRental(newRental);
+        ledger.record(carSlot, carTable.companySymbol(carSlot), newRental, 1);
+        customers.add(customer, newRental.id);
+        schedule(newRental, today);
+        bookings.add(carSlot, Booking{startDate.serial, returnDate.serial, newRental.id});
+        calendar.book(carSlot, startDate.serial, returnDate.serial);
+        rentalsDirty = true;
+        ticket = queueJournal("R|" + newRental.toFileString() + "\n", 1);
+    }
+    awaitJournal(ticket);
+    return newRental;
+}
+
+Result<int> RentalEngine::lateFee(int rentalId) const {
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    const Rental* rental = findRental(rentalId);
+    if (!rental) return RentalStatus::RentalNotFound;
+    if (!rental->isActive) return RentalStatus::AlreadyReturned;
+    int carSlot = findCar(rental->carId);
+    if (carSlot < 0) return RentalStatus::CarNotFound;
+    return rental->calculateLateFee(carTable.dailyRent(carSlot), getToday());
+}
+
+Result<Rental> RentalEngine::returnRental(int rentalId) {
+    ScopedTimer timer(stats, StatTimer::Return);
+    Rental returned;
+    uint64_t ticket;
+    {
+        shared_lock<shared_mutex> fleetRead(fleetLock);
+        unique_lock<shared_mutex> rentalWrite(rentalLock);
+        Rental* rental = findRentalById(rentalId);
+        if (!rental) return RentalStatus::RentalNotFound;
+        if (!rental->isActive) return RentalStatus::AlreadyReturned;
+        int carSlot = findCar(rental->carId);
+        if (carSlot < 0) return RentalStatus::CarNotFound;
+        
+        Date today = getToday();
+        bool started = rental->rentDate <= today;
+        int fee = rental->calculateLateFee(carTable.dailyRent(carSlot), today);
+        rental = archiveRental(rentalId);
+        Symbol company = carTable.companySymbol(carSlot);
+        if (started) {
+            // Only the days the car was actually out count as rented
+            rental->returnedOn = Date::fromSerial(ledger.moveReturn(carSlot, company, *rental, today.serial));
+            rental->totalAmount += fee;
+            ledger.addRevenue(carSlot, company, *rental, fee);
+            carTable.setAvailable(carSlot, true);
+            carsDirty = true;
+        } else {
+            ledger.record(carSlot, company, *rental, -1);
+            rental->totalAmount = 0; // cancelled before it began
+        }
+        returned = *rental;
+        rentalsDirty = true;
+        ticket = queueJournal("R|" + returned.toFileString() + "\n", 1);
+    }
+    awaitJournal(ticket);
+    return returned;
+}
+
+Result<Car> RentalEngine::lookupCar(int carId) const {
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    int carSlot = findCar(carId);
+    if (carSlot < 0) return RentalStatus::CarNotFound;
+    return carTable.get(carSlot);
+}
+
+Result<Rental> RentalEngine::lookupRental(int rentalId) const {
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    const Rental* rental = findRental(rentalId);
+    if (!rental) return RentalStatus::RentalNotFound;
+    return *rental;
+}
+
+vector<Car> RentalEngine::availableCars(int lo, int hi) const {
+    ScopedTimer timer(stats, StatTimer::ListAvailable);
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    vector<Car> cars;
+    for (int carId : carTable.filterAvailable(lo, hi)) {
+        cars.push_back(carTable.get(findCar(carId)));
+    }
+    stats.add(StatCounter::RowsListed, cars.size());
+    return cars;
+}
+
+vector<Car> RentalEngine::findCars(const FleetQuery& query, FleetQueryPlan* plan) const {
+    ScopedTimer timer(stats, StatTimer::FindCars);
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    vector<Car> cars;
+    for (int carId : carTable.select(query, plan)) {
+        cars.push_back(carTable.get(findCar(carId)));
+    }
+    stats.add(StatCounter::RowsListed, cars.size());
+    return cars;
+}
+
+vector<Rental> RentalEngine::activeRentalsSnapshot() const {
+    ScopedTimer timer(stats, StatTimer::ListRented);
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    stats.add(StatCounter::RowsListed, activeTable.size());
+    return activeTable;
+}
+
+vector<int> RentalEngine::freeCars(const Date& first, const Date& last) const {
+    ScopedTimer timer(stats, StatTimer::FreeCars);
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    vector<int> result;
+    for (size_t i = 0; i < carTable.size(); i++) {
+        if (bookings.isFree(i, first.serial, last.serial)) {
+            result.push_back(carTable.id(i));
+        }
+    }
+    return result;
+}
+
+Result<vector<int>> RentalEngine::freeCarsPerDay(const Date& first, int dayCount, string_view company) const {
+    if (dayCount <= 0) return RentalStatus::InvalidAmount;
+    if (first < getToday()) return RentalStatus::StartDateInPast;
+    
+    ScopedTimer timer(stats, StatTimer::Calendar);
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    vector<uint64_t> mask = carTable.companyMask(company);
+    vector<int> counts(dayCount);
+    for (int i = 0; i < dayCount; i++) {
+        counts[i] = calendar.freeCount(first.serial + i, mask);
+    }
+    return counts;
+}
+
+vector<RentalEngine::CustomerSummary> RentalEngine::findCustomers(string_view prefix, size_t limit) const {
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    vector<CustomerSummary> result;
+    for (Symbol customer : customers.matching(prefix, limit)) {
+        CustomerSummary summary;
+        summary.id = customers.firstRental(customer);
+        summary.name = symbols().name(customer);
+        for (int rentalId = customers.firstRental(customer); rentalId >= 0; rentalId = customers.nextRental(rentalId)) {
+            summary.activeRentals += findRental(rentalId)->isActive;
+            summary.totalRentals++;
+        }
+        result.push_back(move(summary));
+    }
+    return result;
+}
+
+vector<Rental> RentalEngine::customerRentals(string_view name, bool activeOnly) const {
+    vector<Rental> result;
+    Symbol customer;
+    if (!symbols().find(name, customer)) return result;
+    
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    for (int rentalId = customers.firstRental(customer); rentalId >= 0; rentalId = customers.nextRental(rentalId)) {
+        const Rental* rental = findRental(rentalId);
+        if (!activeOnly || rental->isActive) {
+            result.push_back(*rental);
+        }
+    }
+    return result;
+}
+
+UsageTotals RentalEngine::usageBetween(const Date& first, const Date& last) const {
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    return ledger.between(first.serial, last.serial);
+}
+
+Result<UsageTotals> RentalEngine::carUsage(int carId) const {
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    int carSlot = findCar(carId);
+    if (carSlot < 0) return RentalStatus::CarNotFound;
+    return ledger.car(carSlot);
+}
+
+vector<RentalEngine::CompanyUsage> RentalEngine::companyUsage() const {
+    shared_lock<shared_mutex> fleetRead(fleetLock);
+    shared_lock<shared_mutex> rentalRead(rentalLock);
+    unordered_map<Symbol, int> carsByCompany;
+    for (size_t i = 0; i < carTable.size(); i++) {
+        carsByCompany[carTable.companySymbol(i)]++;
+    }
+    
+    vector<CompanyUsage> result;
+    for (const auto& entry : carsByCompany) {
+        CompanyUsage usage;
+        usage.company = symbols().name(entry.first);
+        usage.cars = entry.second;
+        usage.totals = ledger.company(entry.first);
+        result.push_back(move(usage));
+    }
+    sort(result.begin(), result.end(), [](const CompanyUsage& a, const CompanyUsage& b) {
+        return a.totals.revenue > b.totals.revenue;
+    });
+    return result;
+}
+
+void RentalEngine::save() {
+    ScopedTimer timer(stats, StatTimer::Save);
+    {
+        unique_lock<mutex> lock(journalLock);
+        journalFlushed.wait(lock, [&] { return !journalFlushing; });
+        flushJournal(lock, true);
+    }
+    if (carsDirty || rentalsDirty) {
+        log() << "Warning: Some data files could not be written." << endl;
+    } else {
+        log() << "All data saved successfully." << endl;
+    }
+}
+
+bool RentalEngine::convertStorage(bool toBinary) {
+    {
+        unique_lock<mutex> lock(journalLock);
+        journalFlushed.wait(lock, [&] { return !journalFlushing; });
+        if (toBinary == binarySnapshot) return false;
+        binarySnapshot = toBinary;
+        carsDirty = true;
+        rentalsDirty = true;
+        flushJournal(lock, true);
+    }
+    
+    // The old files are removed once the new ones are written
+    if (carsDirty || rentalsDirty) {
+        log() << "Warning: Could not write the converted data, keeping the old files." << endl;
+    } else if (toBinary) {
+        remove(CARS_FILE.c_str());
+        remove(RENTALS_FILE.c_str());
+    } else {
+        remove(SNAPSHOT_FILE.c_str());
+    }
+    return true;
+}
+
+vector<pair<string, string>> RentalEngine::dataFiles() const {
+    if (binarySnapshot) {
+        return {{SNAPSHOT_FILE, "Cars and rentals data"}};
+    }
+    return {{CARS_FILE, "Cars data"}, {RENTALS_FILE, "Rentals data"}};
+}
+
+// A car is rented exactly when an active rental covers today. Renting and
+// returning do not journal the car record, so the flags are derived from
+// the rentals after loading instead of trusting the car records.
+void RentalEngine::rebuildAvailability() {
+    vector<bool> loaded(carTable.size());
+    for (size_t i = 0; i < carTable.size(); i++) {
+        loaded[i] = carTable.isAvailable(i);
+        carTable.setAvailable(i, true);
+    }
+    Date today = getToday();
+    for (const auto& rental : activeTable) {
+        int carSlot = findCar(rental.carId);
+        if (carSlot >= 0 && rental.rentDate <= today) {
+            carTable.setAvailable(carSlot, false);
+        }
+    }
+    for (size_t i = 0; i < carTable.size(); i++) {
+        if (carTable.isAvailable(i) != loaded[i]) {
+            carsDirty = true;
+            break;
+        }
+    }
+}
+
+void RentalEngine::loadAllData(size_t loadThreads) {
+    {
+        ScopedTimer timer(stats, StatTimer::Load);
+        loadLegacyIdCounters();
+        binarySnapshot = loadBinarySnapshot();
+        if (!binarySnapshot) {
+            loadCarsFromFile();
+            loadRentalsFromFile(loadThreads);
+        }
+        rebuildIndexes();
+        replayJournal();
+        rebuildAvailability();
+        rebuildSchedule();
+        rebuildLedger();
+        rebuildCustomers();
+        openJournal();
+        refresh(); // Update status based on current date
+    }
+    save(); // Save updated status back to file
+}
@@ -0,0 +1,1508 @@
+#ifndef RENTAL_ENGINE_H
+#define RENTAL_ENGINE_H
+
+// Headless car rental engine shared by the console front end and any
+// other program that embeds it. CMakeLists.txt builds it as the static
+// library target rental_engine; link programs against that target.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <functional>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cctype>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+// ==================== Date Structure and Functions ====================
+
+// Dates are stored as a serial day number (days since 1 Jan 1970), so
+// comparisons are single integer compares and differences are exact.
+// The civil conversions follow Howard Hinnant's days_from_civil and
+// civil_from_days algorithms.
+
+struct Date {
+    int32_t serial;
+    
+    constexpr Date() : serial(daysFromCivil(1, 1, 2000)) {}
+    constexpr Date(int d, int m, int y) : serial(daysFromCivil(d, m, y)) {}
+    
+    static constexpr Date fromSerial(int32_t days) {
+        Date date;
+        date.serial = days;
+        return date;
+    }
+    
+    static constexpr int32_t daysFromCivil(int d, int m, int y) {
+        y -= m <= 2;
+        int era = (y >= 0 ? y : y - 399) / 400;
+        int yearOfEra = y - era * 400;
+        int dayOfYear = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+    
+    static constexpr void civilFromDays(int32_t days, int& d, int& m, int& y) {
+        days += 719468;
+        int era = (days >= 0 ? days : days - 146096) / 146097;
+        int dayOfEra = days - era * 146097;
+        int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        int mp = (5 * dayOfYear + 2) / 153;
+        d = dayOfYear - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = yearOfEra + era * 400 + (m <= 2);
+    }
+    
+    int day() const { int d, m, y; civilFromDays(serial, d, m, y); return d; }
+    int month() const { int d, m, y; civilFromDays(serial, d, m, y); return m; }
+    int year() const { int d, m, y; civilFromDays(serial, d, m, y); return y; }
+    
+    static bool isValid(int d, int m, int y) {
+        if (y < 1900 || y > 2100) return false;
+        if (m < 1 || m > 12) return false;
+        
+        // Check days in month
+        int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        
+        // Handle leap year for February
+        if (m == 2) {
+            bool isLeap = (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
+            if (d < 1 || d > (isLeap ? 29 : 28)) return false;
+        } else {
+            if (d < 1 || d > daysInMonth[m-1]) return false;
+        }
+        
+        return true;
+    }
+    
+    constexpr bool operator<(const Date& other) const { return serial < other.serial; }
+    constexpr bool operator<=(const Date& other) const { return serial <= other.serial; }
+    constexpr bool operator>(const Date& other) const { return serial > other.serial; }
+    constexpr bool operator==(const Date& other) const { return serial == other.serial; }
+    
+    // Number of days from this date to other (positive when other is later)
+    constexpr int differenceInDays(const Date& other) const {
+        return other.serial - serial;
+    }
+    
+    std::string toString() const {
+        int d, m, y;
+        civilFromDays(serial, d, m, y);
+        return std::to_string(d) + "/" + std::to_string(m) + "/" + std::to_string(y);
+    }
+    
+    // Appends the "dd mm yyyy" file form to out.
+    void appendTo(std::string& out) const;
+    
+    std::string toFileString() const {
+        std::string text;
+        appendTo(text);
+        return text;
+    }
+    
+    static bool parse(std::string_view text, Date& date);
+};
+
+static_assert(Date(1, 1, 1970).serial == 0, "serial day epoch");
+static_assert(Date(1, 3, 2024).differenceInDays(Date(1, 3, 2025)) == 365, "leap year arithmetic");
+
+
+Date getToday();
+
+// ==================== Text Parsing Helpers ====================
+
+// Splits off the next '|' separated field. The last field of a line is
+// whatever remains after the final separator.
+bool nextField(std::string_view& rest, std::string_view& field);
+bool parseInt(std::string_view text, int& value);
+bool parseFlag(std::string_view text, bool& value);
+
+// Appends value in decimal without building a temporary string.
+void appendInt(std::string& out, int64_t value);
+
+// ==================== Symbol Table ====================
+
+// Company, model and customer names repeat heavily, so each distinct name
+// is stored once and records refer to it by a 32-bit handle. Equal names
+// always get the same handle, so comparing names is an integer compare.
+
+typedef uint32_t Symbol;
+
+class SymbolTable {
+private:
+    // Names live in fixed-size chunks that never move, so name() can read
+    // them without a lock while other threads intern new names. The bytes
+    // themselves are packed into large arena blocks, so a name costs no
+    // allocation of its own.
+    static const size_t CHUNK_BITS = 12;
+    static const size_t CHUNK_SIZE = (size_t)1 << CHUNK_BITS;
+    static const size_t MAX_CHUNKS = (size_t)1 << 16;
+    static constexpr size_t ARENA_BLOCK = 64 << 10;
+    static constexpr Symbol NO_SYMBOL = std::numeric_limits<Symbol>::max();
+    
+    std::unique_ptr<std::string_view[]> chunks[MAX_CHUNKS];
+    std::atomic<uint32_t> count;
+    std::vector<std::unique_ptr<char[]>> arena;
+    char* arenaNext = nullptr;
+    size_t arenaFree = 0;
+    // Open-addressing table of symbols by name, kept at most half full
+    std::vector<Symbol> lookup;
+    mutable std::shared_mutex lookupLock;
+    
+    // Slot holding name, or the empty slot where it would go.
+    size_t findSlot(std::string_view name) const {
+        size_t mask = lookup.size() - 1;
+        size_t slot = std::hash<std::string_view>()(name) & mask;
+        while (lookup[slot] != NO_SYMBOL && this->name(lookup[slot]) != name) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+    
+    std::string_view store(std::string_view name) {
+        if (name.size() > arenaFree) {
+            size_t size = std::max(ARENA_BLOCK, name.size());
+            arena.emplace_back(new char[size]);
+            arenaNext = arena.back().get();
+            arenaFree = size;
+        }
+        std::copy(name.begin(), name.end(), arenaNext);
+        std::string_view stored(arenaNext, name.size());
+        arenaNext += name.size();
+        arenaFree -= name.size();
+        return stored;
+    }
+    
+    void grow() {
+        lookup.assign(lookup.size() * 2, NO_SYMBOL);
+        for (Symbol symbol = 0; symbol < count.load(std::memory_order_relaxed); symbol++) {
+            lookup[findSlot(name(symbol))] = symbol;
+        }
+    }
+    
+public:
+    SymbolTable() : count(0), lookup(1024, NO_SYMBOL) {
+        intern(""); // Symbol 0 is the empty name
+    }
+    
+    Symbol intern(std::string_view name) {
+        {
+            std::shared_lock<std::shared_mutex> lock(lookupLock);
+            Symbol found = lookup[findSlot(name)];
+            if (found != NO_SYMBOL) {
+                return found;
+            }
+        }
+        
+        std::unique_lock<std::shared_mutex> lock(lookupLock);
+        size_t slot = findSlot(name);
+        if (lookup[slot] != NO_SYMBOL) {
+            return lookup[slot];
+        }
+        
+        Symbol symbol = count.load(std::memory_order_relaxed);
+        std::unique_ptr<std::string_view[]>& chunk = chunks[symbol >> CHUNK_BITS];
+        if (!chunk) {
+            chunk.reset(new std::string_view[CHUNK_SIZE]);
+        }
+        chunk[symbol & (CHUNK_SIZE - 1)] = store(name);
+        lookup[slot] = symbol;
+        count.store(symbol + 1, std::memory_order_release);
+        if ((size_t)(symbol + 1) * 2 > lookup.size()) {
+            grow();
+        }
+        return symbol;
+    }
+    
+    // Looks a name up without interning it.
+    bool find(std::string_view name, Symbol& symbol) const {
+        std::shared_lock<std::shared_mutex> lock(lookupLock);
+        Symbol found = lookup[findSlot(name)];
+        if (found == NO_SYMBOL) return false;
+        symbol = found;
+        return true;
+    }
+    
+    std::string_view name(Symbol symbol) const {
+        return chunks[symbol >> CHUNK_BITS][symbol & (CHUNK_SIZE - 1)];
+    }
+    
+    size_t size() const {
+        return count.load(std::memory_order_acquire);
+    }
+};
+
+SymbolTable& symbols();
+
+// ==================== Car Structure ====================
+
+// Largest ids the engine hands out or accepts from the data files. Ids
+// index dense tables, so a corrupt id must not be able to size them; the
+// bounds are far above any real fleet or rental history.
+constexpr int MAX_CAR_ID = (1 << 22) - 1;
+constexpr int MAX_RENTAL_ID = (1 << 25) - 1;
+
+struct Car {
+    int id;
+    Symbol company;
+    Symbol model;
+    int dailyRent;
+    bool isAvailable;
+    
+    Car() : id(-1), company(0), model(0), dailyRent(0), isAvailable(true) {} // Default constructor for file loading
+    
+    Car(int carId, Symbol comp, Symbol mod, int rent)
+        : id(carId), company(comp), model(mod), dailyRent(rent), isAvailable(true) {}
+    
+    // Appends the cars_data.txt line, without the newline, to out.
+    void appendTo(std::string& out) const {
+        appendInt(out, id);
+        out += '|';
+        out += symbols().name(company);
+        out += '|';
+        out += symbols().name(model);
+        out += '|';
+        appendInt(out, dailyRent);
+        out += isAvailable ? "|1" : "|0";
+    }
+    
+    std::string toFileString() const {
+        std::string line;
+        appendTo(line);
+        return line;
+    }
+    
+    // Parses one line of cars_data.txt into car. On failure error names
+    // the offending field and car is left partially filled.
+    static bool parse(std::string_view line, Car& car, const char*& error) {
+        std::string_view field;
+        error = "missing fields";
+        
+        if (!nextField(line, field)) return false;
+        if (!parseInt(field, car.id)) { error = "bad car id"; return false; }
+        if (car.id < 0 || car.id > MAX_CAR_ID) { error = "car id out of range"; return false; }
+        if (!nextField(line, field)) return false;
+        car.company = symbols().intern(field);
+        if (!nextField(line, field)) return false;
+        car.model = symbols().intern(field);
+        if (!nextField(line, field)) return false;
+        if (!parseInt(field, car.dailyRent)) { error = "bad daily rent"; return false; }
+        if (!nextField(line, field)) return false;
+        if (!parseFlag(field, car.isAvailable)) { error = "bad availability flag"; return false; }
+        
+        return true;
+    }
+};
+
+
+// ==================== Fleet Table ====================
+
+// Cars stored column by column. The hot columns (id, daily rent and the
+// availability bitset) are contiguous so availability and price filters
+// never touch the name strings.
+
+// Filters, order and limit for FleetTable::select. Empty or default
+// fields do not filter.
+struct FleetQuery {
+    enum class Order { Fleet, RentAscending, RentDescending };
+    
+    std::string company;         // exact company name
+    std::string modelContains;   // case-insensitive part of the model name
+    int minRent = std::numeric_limits<int>::min();
+    int maxRent = std::numeric_limits<int>::max();
+    bool availableOnly = false;
+    Order order = Order::Fleet;
+    size_t limit = 0;       // 0 for no limit
+};
+
+// How select() answered a query: "company index", "rent index" or "full
+// scan", and the number of cars it looked at.
+struct FleetQueryPlan {
+    const char* index = "full scan";
+    size_t examined = 0;
+};
+
+class FleetTable {
+private:
+    std::vector<int> ids;
+    std::vector<int> rents;
+    // Availability words are atomic so readers holding only the fleet lock
+    // can see them while a booking (serialized elsewhere) flips a bit.
+    std::deque<std::atomic<uint64_t>> availableBits;
+    std::vector<Symbol> companies;
+    std::vector<Symbol> models;
+    std::vector<Symbol> fullNames;
+    std::vector<int> slotsById;
+    
+    // Secondary indexes for select(). Company lists stay in slot order.
+    // The rent order is merged lazily: cars added since the last query
+    // that needed it are sorted and merged in by the next one.
+    std::unordered_map<Symbol, std::vector<uint32_t>> slotsByCompany;
+    mutable std::vector<uint32_t> slotsByRent;
+    mutable std::mutex rentOrderLock;
+    
+    static Symbol internFullName(const Car& car) {
+        std::string fullName(symbols().name(car.company));
+        fullName += ' ';
+        fullName += symbols().name(car.model);
+        return symbols().intern(fullName);
+    }
+    
+    uint64_t rentRangeMask(size_t first, size_t count, int lo, int hi) const;
+    const std::vector<uint32_t>& rentOrder() const;
+    
+public:
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    
+    void clear() {
+        ids.clear();
+        rents.clear();
+        availableBits.clear();
+        companies.clear();
+        models.clear();
+        fullNames.clear();
+        slotsById.clear();
+        slotsByCompany.clear();
+        slotsByRent.clear();
+    }
+    
+    void reserve(size_t count) {
+        ids.reserve(count);
+        rents.reserve(count);
+        companies.reserve(count);
+        models.reserve(count);
+        fullNames.reserve(count);
+    }
+    
+    // Appends a car and returns its slot.
+    size_t add(const Car& car) {
+        size_t slot = ids.size();
+        ids.push_back(car.id);
+        rents.push_back(car.dailyRent);
+        companies.push_back(car.company);
+        models.push_back(car.model);
+        fullNames.push_back(internFullName(car));
+        slotsByCompany[car.company].push_back(slot);
+        if (slot % 64 == 0) {
+            availableBits.emplace_back(0);
+        }
+        setAvailable(slot, car.isAvailable);
+        
+        if (car.id >= 0) {
+            if ((size_t)car.id >= slotsById.size()) {
+                slotsById.resize(car.id + 1, -1);
+            }
+            slotsById[car.id] = slot;
+        }
+        return slot;
+    }
+    
+    // Overwrites the car in slot. The id must stay the same.
+    void set(size_t slot, const Car& car) {
+        if (companies[slot] != car.company) {
+            std::vector<uint32_t>& previous = slotsByCompany[companies[slot]];
+            previous.erase(find(previous.begin(), previous.end(), (uint32_t)slot));
+            std::vector<uint32_t>& next = slotsByCompany[car.company];
+            next.insert(std::upper_bound(next.begin(), next.end(), (uint32_t)slot), slot);
+        }
+        if (rents[slot] != car.dailyRent) {
+            slotsByRent.clear();
+        }
+        rents[slot] = car.dailyRent;
+        companies[slot] = car.company;
+        models[slot] = car.model;
+        fullNames[slot] = internFullName(car);
+        setAvailable(slot, car.isAvailable);
+    }
+    
+    Car get(size_t slot) const {
+        Car car(ids[slot], companies[slot], models[slot], rents[slot]);
+        car.isAvailable = isAvailable(slot);
+        return car;
+    }
+    
+    // Slot of the car with this id, or -1.
+    int slotOf(int carId) const {
+        if (carId < 0 || (size_t)carId >= slotsById.size()) return -1;
+        return slotsById[carId];
+    }
+    
+    int id(size_t slot) const { return ids[slot]; }
+    int dailyRent(size_t slot) const { return rents[slot]; }
+    Symbol companySymbol(size_t slot) const { return companies[slot]; }
+    Symbol modelSymbol(size_t slot) const { return models[slot]; }
+    
+    std::string_view company(size_t slot) const { return symbols().name(companies[slot]); }
+    std::string_view model(size_t slot) const { return symbols().name(models[slot]); }
+    std::string_view fullName(size_t slot) const { return symbols().name(fullNames[slot]); }
+    
+    bool isAvailable(size_t slot) const {
+        return (availableBits[slot / 64].load(std::memory_order_acquire) >> (slot % 64)) & 1;
+    }
+    
+    void setAvailable(size_t slot, bool available) {
+        uint64_t bit = (uint64_t)1 << (slot % 64);
+        if (available) {
+            availableBits[slot / 64].fetch_or(bit, std::memory_order_acq_rel);
+        } else {
+            availableBits[slot / 64].fetch_and(~bit, std::memory_order_acq_rel);
+        }
+    }
+    
+    size_t countAvailable() const {
+        size_t count = 0;
+        for (const auto& word : availableBits) {
+            count += __builtin_popcountll(word.load(std::memory_order_acquire));
+        }
+        return count;
+    }
+    
+    bool anyAvailable() const {
+        for (const auto& word : availableBits) {
+            if (word.load(std::memory_order_acquire)) return true;
+        }
+        return false;
+    }
+    
+    // Ids of available cars with lo <= dailyRent <= hi, in slot order.
+    std::vector<int> filterAvailable(int lo = std::numeric_limits<int>::min(),
+                                     int hi = std::numeric_limits<int>::max()) const;
+    
+    // Ids of the cars matching query. Picks the company list, a walk of
+    // the rent order or a full scan, whichever should look at the fewest
+    // cars, and records the choice in plan.
+    std::vector<int> select(const FleetQuery& query, FleetQueryPlan* plan = nullptr) const;
+    
+    // Slots of the cars of company in slot order, or null if it has none.
+    const std::vector<uint32_t>* companySlots(std::string_view company) const {
+        Symbol symbol;
+        if (!symbols().find(company, symbol)) return nullptr;
+        auto found = slotsByCompany.find(symbol);
+        return found == slotsByCompany.end() ? nullptr : &found->second;
+    }
+    
+    // Number of cars of company, or of the whole fleet when it is empty.
+    size_t countCompany(std::string_view company) const {
+        if (company.empty()) return ids.size();
+        const std::vector<uint32_t>* slots = companySlots(company);
+        return slots ? slots->size() : 0;
+    }
+    
+    // Bitmap over slots of the cars of company, or of every car when
+    // company is empty.
+    std::vector<uint64_t> companyMask(std::string_view company) const;
+};
+
+// ==================== Rental Structure ====================
+
+struct Rental {
+    int id;
+    int carId;
+    Symbol customer;
+    Date rentDate;
+    Date returnDate;
+    Date returnedOn; // day the car came back; returnDate until it has
+    int totalAmount;
+    bool isActive;
+    
+    Rental() : id(-1), carId(-1), customer(0), totalAmount(0), isActive(false) {} // Default constructor
+    
+    Rental(int rentId, int cId, Symbol cust, const Date& rDate, const Date& retDate, int amount)
+        : id(rentId), carId(cId), customer(cust), rentDate(rDate), 
+          returnDate(retDate), returnedOn(retDate), totalAmount(amount), isActive(true) {}
+    
+    std::string_view customerName() const {
+        return symbols().name(customer);
+    }
+    
+    // Reservations cancelled before they started are kept with no charge.
+    bool wasCancelled() const {
+        return !isActive && totalAmount == 0;
+    }
+    
+    int calculateLateFee(int dailyRate, const Date& actualReturn) const {
+        if (actualReturn <= returnDate) return 0;
+        
+        int daysLate = returnDate.differenceInDays(actualReturn);
+        return daysLate * dailyRate * 1.5; // 50% late fee
+    }
+    
+    // Appends the rentals_data.txt line, without the newline, to out.
+    void appendTo(std::string& out) const {
+        appendInt(out, id);
+        out += '|';
+        appendInt(out, carId);
+        out += '|';
+        out += customerName();
+        out += '|';
+        rentDate.appendTo(out);
+        out += '|';
+        returnDate.appendTo(out);
+        out += '|';
+        appendInt(out, totalAmount);
+        out += isActive ? "|1" : "|0";
+        // Only rentals returned early or late carry the day they came back
+        if (!(returnedOn == returnDate)) {
+            out += '|';
+            returnedOn.appendTo(out);
+        }
+    }
+    
+    std::string toFileString() const {
+        std::string line;
+        appendTo(line);
+        return line;
+    }
+    
+    // Parses one line of rentals_data.txt into rental. On failure error
+    // names the offending field and rental is left partially filled.
+    static bool parse(std::string_view line, Rental& rental, const char*& error) {
+        std::string_view customerName;
+        if (!parse(line, rental, customerName, error)) return false;
+        rental.customer = symbols().intern(customerName);
+        return true;
+    }
+    
+    // Same, but leaves the customer name uninterned in customerName, a
+    // view into line. Touches no shared state, so loader threads can use
+    // it side by side.
+    static bool parse(std::string_view line, Rental& rental, std::string_view& customerName, const char*& error) {
+        std::string_view field;
+        error = "missing fields";
+        
+        if (!nextField(line, field)) return false;
+        if (!parseInt(field, rental.id)) { error = "bad rental id"; return false; }
+        if (rental.id < 0 || rental.id > MAX_RENTAL_ID) { error = "rental id out of range"; return false; }
+        if (!nextField(line, field)) return false;
+        if (!parseInt(field, rental.carId)) { error = "bad car id"; return false; }
+        if (!nextField(line, customerName)) return false;
+        if (!nextField(line, field)) return false;
+        if (!Date::parse(field, rental.rentDate)) { error = "bad rent date"; return false; }
+        if (!nextField(line, field)) return false;
+        if (!Date::parse(field, rental.returnDate)) { error = "bad return date"; return false; }
+        if (!nextField(line, field)) return false;
+        if (!parseInt(field, rental.totalAmount)) { error = "bad total amount"; return false; }
+        if (!nextField(line, field)) return false;
+        if (!parseFlag(field, rental.isActive)) { error = "bad active flag"; return false; }
+        rental.returnedOn = rental.returnDate;
+        if (nextField(line, field) && !Date::parse(field, rental.returnedOn)) { error = "bad returned date"; return false; }
+        
+        return true;
+    }
+};
+
+
+// ==================== Booking Index ====================
+
+// Days each car is taken by an active rental or a future reservation, as
+// inclusive serial day ranges. A car's ranges never overlap, so keeping
+// them sorted by first day also sorts them by last day, and an overlap
+// check is one binary search. Returned rentals are not indexed, so the
+// cost does not grow with the rental history.
+
+struct Booking {
+    int32_t first;
+    int32_t last;
+    int rentalId;
+};
+
+class BookingIndex {
+private:
+    std::vector<std::vector<Booking>> byCar; // indexed by car slot
+    
+public:
+    void clear() {
+        byCar.clear();
+    }
+    
+    bool isFree(size_t carSlot, int32_t first, int32_t last) const {
+        if (carSlot >= byCar.size()) return true;
+        const std::vector<Booking>& bookings = byCar[carSlot];
+        auto next = std::lower_bound(bookings.begin(), bookings.end(), first,
+                                     [](const Booking& booking, int32_t day) { return booking.last < day; });
+        return next == bookings.end() || next->first > last;
+    }
+    
+    void add(size_t carSlot, const Booking& booking) {
+        if (carSlot >= byCar.size()) {
+            byCar.resize(carSlot + 1);
+        }
+        std::vector<Booking>& bookings = byCar[carSlot];
+        auto position = std::upper_bound(bookings.begin(), bookings.end(), booking.first,
+                                         [](int32_t day, const Booking& other) { return day < other.first; });
+        bookings.insert(position, booking);
+    }
+    
+    void remove(size_t carSlot, int rentalId) {
+        if (carSlot >= byCar.size()) return;
+        std::vector<Booking>& bookings = byCar[carSlot];
+        for (size_t i = 0; i < bookings.size(); i++) {
+            if (bookings[i].rentalId == rentalId) {
+                bookings.erase(bookings.begin() + i);
+                return;
+            }
+        }
+    }
+};
+
+// ==================== Availability Calendar ====================
+
+// Which cars are taken on each day from today on: one bitmap over car
+// slots per day. Counting the free cars of a set on a day is an AND with
+// the set's slot mask and a popcount, 64 cars per word. Rows are created
+// as bookings reach further ahead and dropped once their day is past;
+// slots past the end of a row are free.
+
+class AvailabilityCalendar {
+private:
+    int32_t firstDay = 0; // serial day of days.front()
+    std::deque<std::vector<uint64_t>> days;
+    
+    void mark(size_t carSlot, int32_t first, int32_t last, bool taken) {
+        size_t word = carSlot / 64;
+        uint64_t bit = (uint64_t)1 << (carSlot % 64);
+        for (int32_t day = std::max(first, firstDay); day <= last; day++) {
+            size_t index = day - firstDay;
+            if (index >= days.size()) {
+                if (!taken) return;
+                days.resize(index + 1);
+            }
+            std::vector<uint64_t>& row = days[index];
+            if (word >= row.size()) {
+                if (!taken) continue;
+                row.resize(word + 1, 0);
+            }
+            row[word] = taken ? (row[word] | bit) : (row[word] & ~bit);
+        }
+    }
+    
+public:
+    void clear(int32_t today) {
+        days.clear();
+        firstDay = today;
+    }
+    
+    // Drops the rows of days before today.
+    void advance(int32_t today) {
+        while (firstDay < today && !days.empty()) {
+            days.pop_front();
+            firstDay++;
+        }
+        firstDay = std::max(firstDay, today);
+    }
+    
+    void book(size_t carSlot, int32_t first, int32_t last) {
+        mark(carSlot, first, last, true);
+    }
+    
+    void release(size_t carSlot, int32_t first, int32_t last) {
+        mark(carSlot, first, last, false);
+    }
+    
+    // Number of cars in mask that are free on day. Days before today
+    // have no rows and count as free.
+    int freeCount(int32_t day, const std::vector<uint64_t>& mask) const {
+        const std::vector<uint64_t>* row = nullptr;
+        if (day >= firstDay && (size_t)(day - firstDay) < days.size()) {
+            row = &days[day - firstDay];
+        }
+        int free = 0;
+        for (size_t i = 0; i < mask.size(); i++) {
+            uint64_t taken = (row && i < row->size()) ? (*row)[i] : 0;
+            free += __builtin_popcountll(mask[i] & ~taken);
+        }
+        return free;
+    }
+};
+
+// ==================== Revenue Ledger ====================
+
+// Sums over serial days with O(log n) point updates and prefix queries.
+class FenwickTree {
+private:
+    std::vector<int64_t> tree; // 1-based
+    
+public:
+    explicit FenwickTree(size_t size = 0) : tree(size + 1, 0) {}
+    
+    void assign(size_t size) {
+        tree.assign(size + 1, 0);
+    }
+    
+    void add(size_t index, int64_t delta) {
+        for (index++; index < tree.size(); index += index & -index) {
+            tree[index] += delta;
+        }
+    }
+    
+    // Sum of entries [0, index].
+    int64_t prefix(size_t index) const {
+        int64_t sum = 0;
+        for (index = std::min(index + 1, tree.size() - 1); index > 0; index -= index & -index) {
+            sum += tree[index];
+        }
+        return sum;
+    }
+};
+
+struct UsageTotals {
+    int64_t revenue = 0;
+    int64_t rentedDays = 0;
+};
+
+// Revenue and rented car-days kept up to date as rentals are booked,
+// returned and cancelled, so reports never walk the rental history. A
+// rental's amount, late fee included, is booked on its start day and it
+// counts as rented on each day from its start up to but not including
+// the day the car came back, or its booked return date while it is out.
+class RevenueLedger {
+private:
+    static constexpr int32_t FIRST_DAY = Date(1, 1, 1900).serial;
+    static constexpr int32_t DAY_COUNT = Date(1, 1, 2101).serial - FIRST_DAY;
+    
+    FenwickTree revenueByDay;
+    // Rented cars per day as a range-update, range-sum pair: a rental adds
+    // one to every day it covers with two point updates in each tree.
+    FenwickTree rentedDelta;
+    FenwickTree rentedWeighted;
+    std::vector<UsageTotals> byCar; // indexed by car slot
+    std::unordered_map<Symbol, UsageTotals> byCompany;
+    
+    static size_t dayIndex(int32_t day) {
+        return std::min(std::max(day, FIRST_DAY), FIRST_DAY + DAY_COUNT - 1) - FIRST_DAY;
+    }
+    
+    void addRentedDays(int32_t first, int32_t last, int64_t count) {
+        if (first > last) return;
+        size_t lo = dayIndex(first), hi = dayIndex(last);
+        rentedDelta.add(lo, count);
+        rentedDelta.add(hi + 1, -count);
+        rentedWeighted.add(lo, count * (int64_t)lo);
+        rentedWeighted.add(hi + 1, -count * (int64_t)(hi + 1));
+    }
+    
+    // Rented car-days over days [0, index].
+    int64_t rentedPrefix(size_t index) const {
+        return rentedDelta.prefix(index) * (int64_t)(index + 1) - rentedWeighted.prefix(index);
+    }
+    
+public:
+    RevenueLedger() : revenueByDay(DAY_COUNT), rentedDelta(DAY_COUNT + 1), rentedWeighted(DAY_COUNT + 1) {}
+    
+    void clear() {
+        revenueByDay.assign(DAY_COUNT);
+        rentedDelta.assign(DAY_COUNT + 1);
+        rentedWeighted.assign(DAY_COUNT + 1);
+        byCar.clear();
+        byCompany.clear();
+    }
+    
+    // Adds (sign 1) or takes back (sign -1) a whole rental.
+    void record(size_t carSlot, Symbol company, const Rental& rental, int sign) {
+        int64_t days = rental.rentDate.differenceInDays(rental.returnedOn);
+        addRentedDays(rental.rentDate.serial, rental.returnedOn.serial - 1, sign);
+        if (carSlot >= byCar.size()) {
+            byCar.resize(carSlot + 1);
+        }
+        byCar[carSlot].rentedDays += sign * days;
+        byCompany[company].rentedDays += sign * days;
+        addRevenue(carSlot, company, rental, sign * (int64_t)rental.totalAmount);
+    }
+    
+    // Moves the end of rental from the day it was counted to returnDay,
+    // taking back the days it was not kept or adding the days it was
+    // kept late. Returns the day the rental now ends on.
+    int32_t moveReturn(size_t carSlot, Symbol company, const Rental& rental, int32_t returnDay) {
+        int32_t booked = rental.returnedOn.serial;
+        returnDay = std::max(returnDay, rental.rentDate.serial);
+        if (returnDay < booked) {
+            addRentedDays(returnDay, booked - 1, -1);
+        } else {
+            addRentedDays(booked, returnDay - 1, 1);
+        }
+        if (carSlot >= byCar.size()) {
+            byCar.resize(carSlot + 1);
+        }
+        byCar[carSlot].rentedDays += returnDay - booked;
+        byCompany[company].rentedDays += returnDay - booked;
+        return returnDay;
+    }
+    
+    // Books an extra charge, such as a late fee, on rental's start day.
+    void addRevenue(size_t carSlot, Symbol company, const Rental& rental, int64_t amount) {
+        if (amount == 0) return;
+        if (carSlot >= byCar.size()) {
+            byCar.resize(carSlot + 1);
+        }
+        byCar[carSlot].revenue += amount;
+        byCompany[company].revenue += amount;
+        revenueByDay.add(dayIndex(rental.rentDate.serial), amount);
+    }
+    
+    // Totals over the days from first to last, inclusive.
+    UsageTotals between(int32_t first, int32_t last) const {
+        UsageTotals totals;
+        if (first > last) return totals;
+        size_t lo = dayIndex(first), hi = dayIndex(last);
+        totals.revenue = revenueByDay.prefix(hi) - (lo ? revenueByDay.prefix(lo - 1) : 0);
+        totals.rentedDays = rentedPrefix(hi) - (lo ? rentedPrefix(lo - 1) : 0);
+        return totals;
+    }
+    
+    UsageTotals car(size_t carSlot) const {
+        return carSlot < byCar.size() ? byCar[carSlot] : UsageTotals();
+    }
+    
+    UsageTotals company(Symbol company) const {
+        auto found = byCompany.find(company);
+        return found != byCompany.end() ? found->second : UsageTotals();
+    }
+};
+
+// ==================== Customer Index ====================
+
+// A customer is identified by the symbol of their name while the process
+// runs. Outside it, the id of their first rental serves as customer id:
+// rentals are never removed, so it stays the same across restarts. Each
+// customer's rentals are chained by rental id in booking order, so
+// looking one up costs time proportional to their own rentals, not the
+// rental table.
+// Names are also kept sorted, ignoring case, for type-ahead search by
+// prefix. Entries are indexed by symbol and rental id, so adding a
+// customer or a rental allocates nothing of its own.
+
+class CustomerIndex {
+private:
+    // Orders symbols and plain text by name, ignoring case.
+    struct FoldedLess {
+        static std::string_view text(Symbol symbol) { return symbols().name(symbol); }
+        static std::string_view text(std::string_view name) { return name; }
+        
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            std::string_view left = text(a), right = text(b);
+            return std::lexicographical_compare(left.begin(), left.end(), right.begin(), right.end(),
+                                                [](char x, char y) { return tolower((unsigned char)x) < tolower((unsigned char)y); });
+        }
+    };
+    
+    struct Chain {
+        int first = -1;
+        int last = -1;
+    };
+    
+    std::vector<Chain> bySymbol;
+    std::vector<int> nextOfRental; // indexed by rental id, -1 ends a chain
+    // Customers sorted by name. New customers are appended and merged in
+    // by the next search.
+    mutable std::vector<Symbol> byName;
+    mutable size_t sortedNames = 0;
+    mutable std::mutex byNameLock;
+    
+public:
+    void clear() {
+        bySymbol.clear();
+        nextOfRental.clear();
+        byName.clear();
+        sortedNames = 0;
+    }
+    
+    // Rentals must be added in increasing id order per customer.
+    void add(Symbol customer, int rentalId) {
+        if (customer >= bySymbol.size()) {
+            bySymbol.resize(std::max<size_t>(customer + 1, bySymbol.size() * 2));
+        }
+        if ((size_t)rentalId >= nextOfRental.size()) {
+            nextOfRental.resize(std::max<size_t>(rentalId + 1, nextOfRental.size() * 2), -1);
+        }
+        
+        Chain& chain = bySymbol[customer];
+        if (chain.first < 0) {
+            chain.first = rentalId;
+            byName.push_back(customer);
+        } else {
+            nextOfRental[chain.last] = rentalId;
+        }
+        chain.last = rentalId;
+    }
+    
+    // First rental id of customer, or -1.
+    int firstRental(Symbol customer) const {
+        return customer < bySymbol.size() ? bySymbol[customer].first : -1;
+    }
+    
+    // The customer's rental after rentalId, or -1.
+    int nextRental(int rentalId) const {
+        return nextOfRental[rentalId];
+    }
+    
+    // Up to limit customers whose name starts with prefix, ignoring case,
+    // in name order.
+    std::vector<Symbol> matching(std::string_view prefix, size_t limit) const {
+        std::lock_guard<std::mutex> lock(byNameLock);
+        if (sortedNames < byName.size()) {
+            std::sort(byName.begin() + sortedNames, byName.end(), FoldedLess());
+            std::inplace_merge(byName.begin(), byName.begin() + sortedNames, byName.end(), FoldedLess());
+            sortedNames = byName.size();
+        }
+        
+        std::vector<Symbol> result;
+        for (auto it = std::lower_bound(byName.begin(), byName.end(), prefix, FoldedLess());
+             it != byName.end() && result.size() < limit; ++it) {
+            std::string_view name = symbols().name(*it);
+            if (name.size() < prefix.size() ||
+                FoldedLess()(prefix, name.substr(0, prefix.size()))) break;
+            result.push_back(*it);
+        }
+        return result;
+    }
+};
+
+// ==================== Engine Statistics ====================
+
+// Latency histograms for the engine's hot paths and counters of the work
+// they do, kept for the life of the engine. Recording costs a clock read
+// and a few relaxed atomic adds, cheap enough to leave on in production.
+// Building every file of the program with -DRENTAL_NO_STATS compiles the
+// recording out; the accessors then report zeros.
+
+enum class StatTimer {
+    Load,
+    Save,
+    SnapshotWrite,
+    JournalWrite,
+    Rent,
+    Reserve,
+    Return,
+    Refresh,
+    ListAvailable,
+    ListRented,
+    History,
+    FindCars,
+    FreeCars,
+    Calendar,
+    Count
+};
+
+enum class StatCounter {
+    CarsParsed,
+    RentalsParsed,
+    JournalReplayed,
+    DataBytesWritten,
+    JournalBytesWritten,
+    JournalSyncs,
+    CarLookups,
+    RentalLookups,
+    RowsListed,
+    Count
+};
+
+const char* statName(StatTimer timer);
+const char* statName(StatCounter counter);
+
+// Log-linear histogram of nanosecond latencies, in the manner of
+// HdrHistogram: values below 8 get a bucket each and every power of two
+// above is split into 8 buckets, so a percentile is never more than
+// 12.5% above the true value. Safe to record into from many threads.
+class alignas(64) LatencyHistogram {
+private:
+    static constexpr int SUB_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+    
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<uint64_t> samples;
+    std::atomic<uint64_t> totalNanos;
+    std::atomic<uint64_t> maxNanos;
+    
+    static int bucketOf(uint64_t nanos) {
+        if (nanos < SUB_BUCKETS) return nanos;
+        int exponent = 63 - __builtin_clzll(nanos);
+        return ((exponent - SUB_BITS + 1) << SUB_BITS) |
+               ((nanos >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+    }
+    
+    // Largest value that lands in bucket.
+    static uint64_t bucketLimit(int bucket);
+    
+public:
+    LatencyHistogram() { reset(); }
+    
+    void record(uint64_t nanos) {
+        counts[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+        uint64_t seen = maxNanos.load(std::memory_order_relaxed);
+        while (nanos > seen && !maxNanos.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+        }
+    }
+    
+    uint64_t count() const { return samples.load(std::memory_order_relaxed); }
+    uint64_t maximum() const { return maxNanos.load(std::memory_order_relaxed); }
+    uint64_t mean() const {
+        uint64_t n = count();
+        return n ? totalNanos.load(std::memory_order_relaxed) / n : 0;
+    }
+    
+    // Latency that fraction (0 to 1) of the samples did not exceed.
+    uint64_t percentile(double fraction) const;
+    
+    void reset();
+};
+
+class EngineStats {
+private:
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> value{0};
+    };
+    
+    LatencyHistogram timers[(int)StatTimer::Count];
+    Counter counters[(int)StatCounter::Count];
+    
+public:
+#ifdef RENTAL_NO_STATS
+    static constexpr bool ENABLED = false;
+#else
+    static constexpr bool ENABLED = true;
+#endif
+    
+    void record(StatTimer timer, uint64_t nanos) {
+        if (ENABLED) timers[(int)timer].record(nanos);
+    }
+    
+    void add(StatCounter counter, uint64_t amount = 1) {
+        if (ENABLED) counters[(int)counter].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    
+    const LatencyHistogram& timer(StatTimer timer) const { return timers[(int)timer]; }
+    uint64_t counter(StatCounter counter) const {
+        return counters[(int)counter].value.load(std::memory_order_relaxed);
+    }
+    
+    void reset();
+};
+
+// Records the time from construction to destruction under timer.
+class ScopedTimer {
+#ifdef RENTAL_NO_STATS
+public:
+    ScopedTimer(EngineStats&, StatTimer) {}
+#else
+private:
+    EngineStats& stats;
+    StatTimer timer;
+    std::chrono::steady_clock::time_point started;
+    
+public:
+    ScopedTimer(EngineStats& stats, StatTimer timer)
+        : stats(stats), timer(timer), started(std::chrono::steady_clock::now()) {}
+    
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - started;
+        stats.record(timer, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+#endif
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+// ==================== Rental Engine ====================
+
+// Longest rental, and how far past today a reservation may start, in
+// days. The horizon keeps the booking index and the calendar rows within
+// about two years of today.
+constexpr int MAX_RENTAL_DAYS = 365;
+constexpr int BOOKING_HORIZON_DAYS = 365;
+
+// Outcome of an engine operation. Anything other than Ok means nothing
+// was changed.
+enum class RentalStatus {
+    Ok,
+    InvalidAmount,
+    CarNotFound,
+    CarNotAvailable,
+    CarBooked,
+    StartDateInPast,
+    StartDateTooFar,
+    ReturnDateNotInFuture,
+    ReturnBeforeStart,
+    RentalTooLong,
+    RentalNotFound,
+    AlreadyReturned,
+    IdsExhausted
+};
+
+// Message shown to the user for status.
+const char* describeStatus(RentalStatus status);
+
+template <typename T>
+struct Result {
+    RentalStatus status;
+    T value;
+    
+    Result(RentalStatus failure) : status(failure), value() {}
+    Result(const T& success) : status(RentalStatus::Ok), value(success) {}
+    
+    bool ok() const { return status == RentalStatus::Ok; }
+    const char* message() const { return describeStatus(status); }
+};
+
+// The rental business logic without any console I/O: the fleet, active
+// and returned rentals, pricing, late fees, id allocation and persistence.
+// Data files live in dataDirectory ("" for the working directory). Load
+// and save progress is written to log, or dropped when log is nullptr.
+// loadThreads sets how many threads parse the rentals text file; 0 picks
+// a count from the file size.
+//
+// Operations and the copying queries may be called from several threads
+// at once. The accessors that return references (fleet(), findRental(),
+// activeRentals(), rentalArchive()) are only safe while no other thread
+// is changing the engine.
+class RentalEngine {
+public:
+    explicit RentalEngine(const std::string& dataDirectory = "", std::ostream* log = &std::cout, size_t loadThreads = 0);
+    ~RentalEngine();
+    
+    RentalEngine(const RentalEngine&) = delete;
+    RentalEngine& operator=(const RentalEngine&) = delete;
+    
+    // ========== Operations ==========
+    // Each change is applied in memory and recorded in the journal.
+    
+    // Returns the new car id.
+    Result<int> addCar(std::string_view company, std::string_view model, int dailyRent);
+    
+    // Price of renting carId from today (or startDate) until returnDate,
+    // without renting it.
+    Result<int> quote(int carId, const Date& returnDate) const;
+    Result<int> quote(int carId, const Date& startDate, const Date& returnDate) const;
+    
+    // Bookings and returns are serialized on the rental tables' lock, so
+    // of several desks renting the same car at once exactly one succeeds.
+    Result<Rental> rent(int carId, std::string_view customer, const Date& returnDate);
+    
+    // Books carId from startDate until returnDate, inclusive. The car
+    // stays available until startDate arrives, which may be at most
+    // BOOKING_HORIZON_DAYS ahead. Returning the rental before then
+    // cancels it free of charge.
+    Result<Rental> reserve(int carId, std::string_view customer, const Date& startDate, const Date& returnDate);
+    
+    // Late fee owed if rentalId were returned today.
+    Result<int> lateFee(int rentalId) const;
+    
+    // Closes an active rental, adding any late fee to its total.
+    Result<Rental> returnRental(int rentalId);
+    
+    // Frees the cars of rentals whose return date has passed. Cheap to
+    // call before every read; it does nothing until the day changes.
+    void refresh();
+    
+    // Same as refresh() on the given day. Later calls for an earlier day,
+    // including refresh() itself, do nothing until the clock catches up.
+    void refreshAsOf(const Date& today);
+    
+    // ========== Queries ==========
+    
+    const FleetTable& fleet() const { return carTable; }
+    
+    // Slot of the car in fleet(), or -1 if there is no such car.
+    int findCar(int carId) const {
+        stats.add(StatCounter::CarLookups);
+        return carTable.slotOf(carId);
+    }
+    
+    const Rental* findRental(int rentalId) const;
+    
+    const std::vector<Rental>& activeRentals() const { return activeTable; }
+    const std::vector<Rental>& rentalArchive() const { return archiveTable; }
+    size_t rentalCount() const { return activeTable.size() + archiveTable.size(); }
+    
+    // Calls visit(rental) for history rows [offset, offset + limit).
+    // Returned rentals come first, then the ones still out. Returns the
+    // number of rows covered. Runs under the rentals read lock, so visit
+    // must not call back into the engine.
+    template <typename Visitor>
+    size_t forEachHistory(size_t offset, size_t limit, Visitor visit) const;
+    
+    // Copies taken under the read locks, for callers sharing the engine
+    // between threads.
+    Result<Car> lookupCar(int carId) const;
+    Result<Rental> lookupRental(int rentalId) const;
+    std::vector<Car> availableCars(int lo = std::numeric_limits<int>::min(),
+                                   int hi = std::numeric_limits<int>::max()) const;
+    std::vector<Rental> activeRentalsSnapshot() const;
+    std::vector<Car> findCars(const FleetQuery& query, FleetQueryPlan* plan = nullptr) const;
+    
+    // Ids of cars with no rental or reservation on any day from first
+    // to last, inclusive.
+    std::vector<int> freeCars(const Date& first, const Date& last) const;
+    
+    // Number of cars free on each of dayCount days from first on. Only
+    // cars of company are counted unless it is empty.
+    Result<std::vector<int>> freeCarsPerDay(const Date& first, int dayCount, std::string_view company = "") const;
+    
+    // ========== Customers ==========
+    
+    // id is the customer's first rental id, which never changes.
+    struct CustomerSummary {
+        int id = -1;
+        std::string name;
+        int activeRentals = 0;
+        int totalRentals = 0;
+    };
+    
+    // Up to limit customers whose name starts with prefix, ignoring case.
+    std::vector<CustomerSummary> findCustomers(std::string_view prefix, size_t limit = 20) const;
+    
+    // Rentals of the customer with exactly this name, oldest first.
+    std::vector<Rental> customerRentals(std::string_view name, bool activeOnly = false) const;
+    
+    // ========== Reports ==========
+    // Answered from running totals, without walking the rental history.
+    
+    struct CompanyUsage {
+        std::string company;
+        int cars = 0;
+        UsageTotals totals;
+    };
+    
+    // Revenue of rentals starting, and car-days rented, from first to last.
+    UsageTotals usageBetween(const Date& first, const Date& last) const;
+    Result<UsageTotals> carUsage(int carId) const;
+    std::vector<CompanyUsage> companyUsage() const;
+    
+    // ========== Persistence ==========
+    
+    // Folds the journal into the data files. Only files whose contents
+    // changed are rewritten, each through a temporary file renamed over
+    // the old one, so a crash never leaves a file half written.
+    void save();
+    
+    // With a positive interval, operations return once their change is
+    // in memory, and a background thread writes the journal records of
+    // each burst together one interval after it starts. A crash can lose
+    // the last interval of changes. Zero, the default, makes every
+    // operation durable before it returns. Meant for a single caller.
+    void setWriteBackInterval(std::chrono::milliseconds interval);
+    
+    // Between these calls journal records are collected in memory and
+    // written with a single fsync at the end. Meant for a single caller;
+    // other threads' changes made meanwhile join the same batch.
+    void beginBatch();
+    void commitBatch();
+    
+    // Switches between the text files and the binary snapshot. Returns
+    // false if the data already uses that format.
+    bool convertStorage(bool toBinary);
+    
+    bool usesBinarySnapshot() const { return binarySnapshot.load(); }
+    
+    // Files holding the data, with a short description of each.
+    std::vector<std::pair<std::string, std::string>> dataFiles() const;
+    
+    // ========== Statistics ==========
+    
+    // Timings and counters since the engine was created. Front ends may
+    // record their own listing work into it as well.
+    EngineStats& statistics() const { return stats; }
+
+private:
+    FleetTable carTable;
+    // Rentals are split into a table of open ones, the cars out now plus
+    // reservations within the booking horizon, and an append-only archive
+    // of returned ones.
+    std::vector<Rental> activeTable;
+    std::vector<Rental> archiveTable;
+    // Next ids to hand out. They are not stored on their own: loading
+    // takes them from the snapshot header's high-water marks, or from the
+    // highest ids met while parsing the text files, and the journal's
+    // records raise them further.
+    std::atomic<int> nextCarId;
+    std::atomic<int> nextRentalId;
+    
+    // Lock order is fleetLock, then rentalLock, then journalLock. Changes
+    // queue their journal record under the first two but neither is held
+    // while writing the journal, since a flush may compact and read both.
+    // fleetLock is taken exclusively only to add cars. Renting and
+    // returning share it but take rentalLock exclusively, so all bookings
+    // and returns run one at a time; only the journal write happens in
+    // parallel. The availability bits are atomic because car lookups and
+    // searches read them under fleetLock alone while a booking flips them.
+    mutable std::shared_mutex fleetLock;
+    mutable std::shared_mutex rentalLock;
+    
+    // Dense id -> slot table. Ids are handed out sequentially from
+    // nextRentalId, so a plain vector indexed by id is enough.
+    struct RentalSlot {
+        int slot = -1;
+        bool active = false;
+    };
+    
+    std::vector<RentalSlot> rentalSlots;
+    
+    // Active rentals keyed by return date, earliest first, and future
+    // reservations keyed by start date. Rentals that were returned early
+    // stay in the queues and are skipped when popped.
+    typedef std::priority_queue<std::pair<int32_t, int>, std::vector<std::pair<int32_t, int>>, std::greater<std::pair<int32_t, int>>> DayQueue;
+    DayQueue expiryQueue;
+    DayQueue startQueue;
+    BookingIndex bookings;
+    AvailabilityCalendar calendar;
+    RevenueLedger ledger;
+    CustomerIndex customers;
+    std::atomic<int32_t> lastAvailabilityCheck;
+    
+    const std::string CARS_FILE;
+    const std::string RENTALS_FILE;
+    // Counter file written by older versions, read once as a floor for
+    // the ids and removed by the next save.
+    const std::string LEGACY_ID_FILE;
+    bool legacyIdFile;
+    const std::string JOURNAL_FILE;
+    const std::string SNAPSHOT_FILE;
+    
+    // Mutations are appended to the journal instead of rewriting the data
+    // files. Once this many records pile up the journal is folded back
+    // into the data files.
+    const int JOURNAL_COMPACT_RECORDS = 1000;
+    
+    // Rental files smaller than this are parsed on the calling thread.
+    const size_t PARALLEL_LOAD_MIN_BYTES = 4 << 20;
+    const size_t PARALLEL_LOAD_MIN_CHUNK = 1 << 20;
+    
+    // Rough length of a rentals file line, to size the save buffer.
+    const size_t SAVE_BYTES_PER_RENTAL = 48;
+    
+    std::ostream* logStream;
+    
+    int journalFd;
+    // Only touched by the thread running a flush. journalSize is the
+    // length of the complete records in the journal file, so a failed
+    // write can be cut back to it.
+    int journalRecords;
+    int64_t journalSize;
+    
+    // Group commit: writers queue records in pendingJournal and wait for a
+    // flush to cover their ticket. One writer at a time does the flush
+    // outside journalLock, so records arriving meanwhile share the next
+    // fsync instead of each paying for their own. Records are queued
+    // while the change is still locked, so the journal keeps the order
+    // the changes were made in.
+    std::mutex journalLock;
+    std::condition_variable journalFlushed;
+    std::string pendingJournal;
+    int pendingRecords;
+    uint64_t journalQueued;
+    uint64_t journalDurable;
+    bool journalFlushing;
+    bool batching;
+    
+    // True when the data lives in SNAPSHOT_FILE instead of the text files.
+    std::atomic<bool> binarySnapshot;
+    
+    // Set when a table differs from its file, and cleared when a save
+    // copies the table. Set under the engine locks, so a save holding
+    // them sees a settled value; a failed write sets them again.
+    std::atomic<bool> carsDirty;
+    std::atomic<bool> rentalsDirty;
+    
+    // Write-back thread, running while writeBackInterval is positive.
+    // Guarded by journalLock.
+    std::chrono::milliseconds writeBackInterval;
+    std::thread writeBackThread;
+    std::condition_variable writeBackWake;
+    bool writeBackStopping;
+    
+    mutable EngineStats stats;
+    
+    std::ostream& log();
+    
+    void indexRental(bool active, size_t slot);
+    void rebuildIndexes();
+    void storeRental(Rental rental);
+    void storeLoadedRentals(std::vector<Rental>& loaded);
+    Rental* archiveRental(int rentalId);
+    Rental* findRentalById(int rentalId);
+    void schedule(const Rental& rental, const Date& today);
+    void rebuildSchedule();
+    void rebuildLedger();
+    void rebuildCustomers();
+    RentalStatus checkBooking(int carSlot, const Date& today, const Date& startDate, const Date& returnDate) const;
+    Result<Rental> book(int carId, Symbol customer, const Date& startDate, const Date& returnDate);
+    
+    // ========== FILE HANDLING METHODS ==========
+    bool writeDataFile(const std::string& path, const std::string& contents, const char* what);
+    std::string carsFileContents() const;
+    void loadCarsFromFile();
+    std::string rentalsFileContents() const;
+    size_t rentalLoadThreads(size_t bytes) const;
+    void loadRentalsFromFile(size_t threadCount = 0);
+    void loadLegacyIdCounters();
+    
+    // ========== BINARY SNAPSHOT METHODS ==========
+    
+    // New contents of the data files of the tables that changed. binary
+    // holds the whole snapshot file when the data is stored that way.
+    struct SnapshotImage {
+        bool cars = false;
+        bool rentals = false;
+        std::string carsText;
+        std::string rentalsText;
+        std::string binary;
+    };
+    
+    std::string binarySnapshotContents() const;
+    bool loadBinarySnapshot();
+    SnapshotImage prepareSnapshot();
+    bool writeSnapshot(const SnapshotImage& image);
+    
+    // ========== JOURNAL METHODS ==========
+    void openJournal();
+    uint64_t queueJournal(const std::string& records, int count);
+    void awaitJournal(uint64_t ticket);
+    void commitJournal(std::unique_lock<std::mutex>& lock, uint64_t ticket);
+    void flushJournal(std::unique_lock<std::mutex>& lock, bool compact);
+    bool writeJournal(const std::string& records);
+    void replayJournal();
+    bool compactJournal();
+    void writeBackLoop();
+    void stopWriteBack();
+    void rebuildAvailability();
+    
+    void loadAllData(size_t loadThreads);
+};
+
+template <typename Visitor>
+size_t RentalEngine::forEachHistory(size_t offset, size_t limit, Visitor visit) const {
+    ScopedTimer timer(stats, StatTimer::History);
+    std::shared_lock<std::shared_mutex> lock(rentalLock);
+    size_t covered = 0;
+    for (const auto* table : {&archiveTable, &activeTable}) {
+        if (offset >= table->size()) {
+            offset -= table->size();
+            continue;
+        }
+        for (size_t i = offset; i < table->size() && covered < limit; i++, covered++) {
+            visit((*table)[i]);
+        }
+        offset = 0;
+    }
+    stats.add(StatCounter::RowsListed, covered);
+    return covered;
+}
+
+#endif
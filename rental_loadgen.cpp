@@ -0,0 +1,243 @@
+// Load generator for the rental server (car_rental --serve). Opens many
+// desk connections, keeps one request in flight on each, and reports
+// throughput and latency percentiles.
+// Build with
+//   cmake -S . -B build && cmake --build build --target rental_loadgen
+// Usage:
+//   rental_loadgen <port or socket path> [clients] [requests per client] [cars]
+// The given number of cars is added first and the run rents, returns and
+// looks up those cars.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+struct Desk {
+    int fd;
+    string input;
+    string request;
+    size_t sent = 0;
+    Clock::time_point started;
+    int remaining = 0;
+    vector<int> rentals; // rental ids this desk holds
+};
+
+int connectTo(const string& address) {
+    bool tcp = !address.empty() && all_of(address.begin(), address.end(),
+                                          [](char c) { return c >= '0' && c <= '9'; });
+    int fd;
+    if (tcp) {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in remote;
+        memset(&remote, 0, sizeof(remote));
+        remote.sin_family = AF_INET;
+        remote.sin_port = htons(stoi(address));
+        remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&remote), sizeof(remote)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un remote;
+        memset(&remote, 0, sizeof(remote));
+        remote.sun_family = AF_UNIX;
+        strncpy(remote.sun_path, address.c_str(), sizeof(remote.sun_path) - 1);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&remote), sizeof(remote)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+// An answer is complete once its last line starts with "ok" or "error".
+bool answerComplete(const string& input) {
+    if (input.empty() || input.back() != '\n') return false;
+    size_t start = input.rfind('\n', input.size() - 2);
+    start = (start == string::npos) ? 0 : start + 1;
+    return input.compare(start, 2, "ok") == 0 || input.compare(start, 5, "error") == 0;
+}
+
+// Sends one command on a blocking socket and waits for its answer.
+string roundTrip(int fd, const string& command) {
+    send(fd, command.data(), command.size(), MSG_NOSIGNAL);
+    string input;
+    char chunk[4096];
+    while (!answerComplete(input)) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n <= 0) break;
+        input.append(chunk, n);
+    }
+    return input;
+}
+
+string returnDateIn(int days) {
+    time_t later = time(0) + (time_t)days * 24 * 60 * 60;
+    tm local;
+    localtime_r(&later, &local);
+    return to_string(local.tm_mday) + " " + to_string(local.tm_mon + 1) + " " + to_string(local.tm_year + 1900);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <port or socket path> [clients] [requests per client] [cars]" << endl;
+        return 1;
+    }
+    string address = argv[1];
+    int clients = argc > 2 ? atoi(argv[2]) : 100;
+    int requests = argc > 3 ? atoi(argv[3]) : 1000;
+    int carCount = argc > 4 ? atoi(argv[4]) : 100;
+
+    // Set up the cars the desks will work with
+    int setupFd = connectTo(address);
+    if (setupFd < 0) {
+        cout << "Could not connect to " << address << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    vector<int> carIds;
+    for (int i = 0; i < carCount; i++) {
+        string answer = roundTrip(setupFd, "add-car|Loadgen|Model " + to_string(i % 10) + "|" + to_string(20 + i % 80) + "\n");
+        if (answer.compare(0, 7, "ok car ") == 0) {
+            carIds.push_back(atoi(answer.c_str() + 7));
+        }
+    }
+    close(setupFd);
+    if (carIds.empty()) {
+        cout << "Could not add any cars." << endl;
+        return 1;
+    }
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    vector<Desk> desks(clients);
+    for (int i = 0; i < clients; i++) {
+        desks[i].fd = connectTo(address);
+        if (desks[i].fd < 0) {
+            cout << "Could not open connection " << i + 1 << ": " << strerror(errno) << endl;
+            return 1;
+        }
+        fcntl(desks[i].fd, F_SETFL, O_NONBLOCK);
+        desks[i].remaining = requests;
+
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u32 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, desks[i].fd, &event);
+    }
+
+    mt19937 random(12345);
+    string returnDate = returnDateIn(30);
+
+    // Picks the next command for a desk: mostly rentals and returns, with
+    // some lookups mixed in.
+    auto nextRequest = [&](Desk& desk) {
+        unsigned kind = random() % 10;
+        int carId = carIds[random() % carIds.size()];
+        if (kind < 4) {
+            desk.request = "rent|" + to_string(carId) + "|Desk customer " + to_string(random() % 1000) + "|" + returnDate + "\n";
+        } else if (kind < 7 && !desk.rentals.empty()) {
+            desk.request = "return|" + to_string(desk.rentals.back()) + "\n";
+            desk.rentals.pop_back();
+        } else {
+            desk.request = "query|car|" + to_string(carId) + "\n";
+        }
+        desk.sent = 0;
+        desk.started = Clock::now();
+    };
+
+    auto sendRequest = [&](Desk& desk) {
+        while (desk.sent < desk.request.size()) {
+            ssize_t n = send(desk.fd, desk.request.data() + desk.sent, desk.request.size() - desk.sent, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            desk.sent += n;
+        }
+    };
+
+    vector<double> latencies;
+    latencies.reserve((size_t)clients * requests);
+    size_t errors = 0;
+    int active = clients;
+
+    Clock::time_point runStarted = Clock::now();
+    for (auto& desk : desks) {
+        nextRequest(desk);
+        sendRequest(desk);
+    }
+
+    vector<epoll_event> events(1024);
+    char chunk[16 * 1024];
+    while (active > 0) {
+        int ready = epoll_wait(epollFd, events.data(), events.size(), 5000);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) {
+            cout << "Server stopped answering." << endl;
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            Desk& desk = desks[events[i].data.u32];
+            ssize_t n;
+            while ((n = read(desk.fd, chunk, sizeof(chunk))) > 0) {
+                desk.input.append(chunk, n);
+            }
+            if (n == 0) {
+                cout << "Server closed a connection." << endl;
+                return 1;
+            }
+            if (!answerComplete(desk.input)) continue;
+
+            latencies.push_back(chrono::duration<double, micro>(Clock::now() - desk.started).count());
+            if (desk.input.compare(0, 5, "error") == 0) {
+                errors++;
+            } else if (desk.input.compare(0, 10, "ok rental ") == 0) {
+                desk.rentals.push_back(atoi(desk.input.c_str() + 10));
+            }
+            desk.input.clear();
+
+            if (--desk.remaining == 0) {
+                active--;
+                continue;
+            }
+            nextRequest(desk);
+            sendRequest(desk);
+        }
+    }
+    double seconds = chrono::duration<double>(Clock::now() - runStarted).count();
+
+    for (auto& desk : desks) {
+        close(desk.fd);
+    }
+    close(epollFd);
+
+    if (latencies.empty()) return 1;
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[min(latencies.size() - 1, (size_t)(p * latencies.size()))];
+    };
+
+    cout << "Requests:   " << latencies.size() << " from " << clients << " connection(s), "
+         << errors << " answered with an error" << endl;
+    cout << "Throughput: " << (size_t)(latencies.size() / seconds) << " requests/sec" << endl;
+    cout << "Latency:    p50 " << (size_t)percentile(0.50) << " us, p90 " << (size_t)percentile(0.90)
+         << " us, p99 " << (size_t)percentile(0.99) << " us, max " << (size_t)latencies.back() << " us" << endl;
+    return 0;
+}
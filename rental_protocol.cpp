@@ -0,0 +1,475 @@
+#include "rental_protocol.h"
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+// ==================== Commands ====================
+
+// Runs one command, appending its output to out. Returns an error
+// message, or nullptr on success.
+static const char* dispatchCommand(RentalEngine& engine, string_view rest, string& out) {
+    string_view command, field;
+    nextField(rest, command);
+    
+    if (command == "add-car") {
+        string_view company, model;
+        int dailyRent;
+        if (!nextField(rest, company) || !nextField(rest, model) ||
+            !nextField(rest, field) || !parseInt(field, dailyRent)) {
+            return "usage: add-car|<company>|<model>|<daily rent>";
+        }
+        
+        Result<int> carId = engine.addCar(company, model, dailyRent);
+        if (!carId.ok()) return carId.message();
+        out += "ok car " + to_string(carId.value) + "\n";
+    } else if (command == "rent") {
+        int carId;
+        string_view customer;
+        Date returnDate;
+        if (!nextField(rest, field) || !parseInt(field, carId) ||
+            !nextField(rest, customer) ||
+            !nextField(rest, field) || !Date::parse(field, returnDate)) {
+            return "usage: rent|<car id>|<customer>|<dd mm yyyy>";
+        }
+        
+        Result<Rental> rental = engine.rent(carId, customer, returnDate);
+        if (!rental.ok()) return rental.message();
+        out += "ok rental " + to_string(rental.value.id) + " amount " + to_string(rental.value.totalAmount) + "\n";
+    } else if (command == "reserve") {
+        int carId;
+        string_view customer;
+        Date startDate, returnDate;
+        if (!nextField(rest, field) || !parseInt(field, carId) ||
+            !nextField(rest, customer) ||
+            !nextField(rest, field) || !Date::parse(field, startDate) ||
+            !nextField(rest, field) || !Date::parse(field, returnDate)) {
+            return "usage: reserve|<car id>|<customer>|<start dd mm yyyy>|<return dd mm yyyy>";
+        }
+        
+        Result<Rental> rental = engine.reserve(carId, customer, startDate, returnDate);
+        if (!rental.ok()) return rental.message();
+        out += "ok rental " + to_string(rental.value.id) + " amount " + to_string(rental.value.totalAmount) + "\n";
+    } else if (command == "return") {
+        int rentalId;
+        if (!nextField(rest, field) || !parseInt(field, rentalId)) {
+            return "usage: return|<rental id>";
+        }
+        
+        Result<Rental> rental = engine.returnRental(rentalId);
+        if (!rental.ok()) return rental.message();
+        out += "ok returned " + to_string(rentalId) + " amount " + to_string(rental.value.totalAmount) + "\n";
+    } else if (command == "query") {
+        nextField(rest, field);
+        size_t rows = 0;
+        if (field == "available") {
+            for (const Car& car : engine.availableCars()) {
+                out += car.toFileString() + "\n";
+                rows++;
+            }
+        } else if (field == "cars") {
+            // Every field is optional; an empty one does not filter
+            FleetQuery query;
+            string_view company, model, minRent, maxRent, available, order, limit;
+            nextField(rest, company);
+            nextField(rest, model);
+            nextField(rest, minRent);
+            nextField(rest, maxRent);
+            nextField(rest, available);
+            nextField(rest, order);
+            nextField(rest, limit);
+            
+            const char* usage = "usage: query|cars|<company>|<model text>|<min rent>|<max rent>|"
+                                "<available 0/1>|<fleet|cheapest|priciest>|<limit>";
+            int number;
+            query.company = company;
+            query.modelContains = model;
+            if (!minRent.empty()) {
+                if (!parseInt(minRent, number)) return usage;
+                query.minRent = number;
+            }
+            if (!maxRent.empty()) {
+                if (!parseInt(maxRent, number)) return usage;
+                query.maxRent = number;
+            }
+            if (!limit.empty()) {
+                if (!parseInt(limit, number) || number < 0) return usage;
+                query.limit = number;
+            }
+            if (!available.empty() && !parseFlag(available, query.availableOnly)) return usage;
+            if (order == "cheapest") {
+                query.order = FleetQuery::Order::RentAscending;
+            } else if (order == "priciest") {
+                query.order = FleetQuery::Order::RentDescending;
+            } else if (!order.empty() && order != "fleet") {
+                return usage;
+            }
+            
+            for (const Car& car : engine.findCars(query)) {
+                out += car.toFileString() + "\n";
+                rows++;
+            }
+        } else if (field == "car") {
+            int carId;
+            if (!nextField(rest, field) || !parseInt(field, carId)) return "usage: query|car|<car id>";
+            Result<Car> car = engine.lookupCar(carId);
+            if (!car.ok()) return car.message();
+            out += car.value.toFileString() + "\n";
+            rows = 1;
+        } else if (field == "rental") {
+            int rentalId;
+            if (!nextField(rest, field) || !parseInt(field, rentalId)) return "usage: query|rental|<rental id>";
+            Result<Rental> rental = engine.lookupRental(rentalId);
+            if (!rental.ok()) return rental.message();
+            out += rental.value.toFileString() + "\n";
+            rows = 1;
+        } else if (field == "free") {
+            Date first, last;
+            if (!nextField(rest, field) || !Date::parse(field, first) ||
+                !nextField(rest, field) || !Date::parse(field, last)) {
+                return "usage: query|free|<first dd mm yyyy>|<last dd mm yyyy>";
+            }
+            for (int carId : engine.freeCars(first, last)) {
+                Result<Car> car = engine.lookupCar(carId);
+                if (!car.ok()) continue;
+                out += car.value.toFileString() + "\n";
+                rows++;
+            }
+        } else if (field == "calendar") {
+            Date first;
+            int dayCount;
+            string_view company;
+            if (!nextField(rest, field) || !Date::parse(field, first) ||
+                !nextField(rest, field) || !parseInt(field, dayCount)) {
+                return "usage: query|calendar|<first dd mm yyyy>|<days>[|<company>]";
+            }
+            nextField(rest, company);
+            Result<vector<int>> counts = engine.freeCarsPerDay(first, dayCount, company);
+            if (!counts.ok()) return counts.message();
+            for (int free : counts.value) {
+                out += first.toFileString() + "|" + to_string(free) + "\n";
+                first = Date::fromSerial(first.serial + 1);
+                rows++;
+            }
+        } else if (field == "revenue") {
+            Date first, last;
+            if (!nextField(rest, field) || !Date::parse(field, first) ||
+                !nextField(rest, field) || !Date::parse(field, last)) {
+                return "usage: query|revenue|<first dd mm yyyy>|<last dd mm yyyy>";
+            }
+            UsageTotals totals = engine.usageBetween(first, last);
+            out += to_string(totals.revenue) + "|" + to_string(totals.rentedDays) + "\n";
+            rows = 1;
+        } else if (field == "companies") {
+            for (const auto& usage : engine.companyUsage()) {
+                out += usage.company + "|" + to_string(usage.cars) + "|" +
+                       to_string(usage.totals.revenue) + "|" + to_string(usage.totals.rentedDays) + "\n";
+                rows++;
+            }
+        } else if (field == "customers") {
+            string_view prefix;
+            nextField(rest, prefix);
+            for (const auto& customer : engine.findCustomers(prefix)) {
+                out += to_string(customer.id) + "|" + customer.name + "|" +
+                       to_string(customer.activeRentals) + "|" + to_string(customer.totalRentals) + "\n";
+                rows++;
+            }
+        } else if (field == "customer") {
+            string_view name;
+            if (!nextField(rest, name)) return "usage: query|customer|<name>";
+            for (const Rental& rental : engine.customerRentals(name)) {
+                out += rental.toFileString() + "\n";
+                rows++;
+            }
+        } else if (field == "history") {
+            int first, limit;
+            if (!nextField(rest, field) || !parseInt(field, first) || first < 1 ||
+                !nextField(rest, field) || !parseInt(field, limit) || limit < 0) {
+                return "usage: query|history|<first row>|<row count>";
+            }
+            rows = engine.forEachHistory(first - 1, limit, [&](const Rental& rental) {
+                out += rental.toFileString() + "\n";
+            });
+        } else if (field == "stats") {
+            const EngineStats& stats = engine.statistics();
+            for (int i = 0; i < (int)StatTimer::Count; i++) {
+                const LatencyHistogram& histogram = stats.timer((StatTimer)i);
+                out += string(statName((StatTimer)i)) + "|" + to_string(histogram.count()) + "|" +
+                       to_string(histogram.mean()) + "|" + to_string(histogram.percentile(0.5)) + "|" +
+                       to_string(histogram.percentile(0.99)) + "|" + to_string(histogram.maximum()) + "\n";
+                rows++;
+            }
+            for (int i = 0; i < (int)StatCounter::Count; i++) {
+                out += string(statName((StatCounter)i)) + "|" + to_string(stats.counter((StatCounter)i)) + "\n";
+                rows++;
+            }
+        } else {
+            return "unknown query";
+        }
+        out += "ok " + to_string(rows) + " row(s)\n";
+    } else {
+        return "unknown command";
+    }
+    return nullptr;
+}
+
+bool runCommand(RentalEngine& engine, string_view line, string& out) {
+    const char* error = dispatchCommand(engine, line, out);
+    if (error) {
+        out += "error ";
+        out += error;
+        out += '\n';
+        return false;
+    }
+    return true;
+}
+
+// ==================== Socket Server ====================
+
+// A single thread runs an epoll loop over all desk connections, with the
+// dataset kept in memory for the life of the process. Commands from one
+// wakeup are journaled as one batch, and their answers are only sent once
+// that batch is on disk.
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+struct Connection {
+    int fd;
+    string input;  // received bytes not yet forming a full line
+    string output; // answers not yet sent
+    size_t sent = 0;
+    bool watchingWrites = false;
+    bool closing = false;
+    bool queued = false;
+    
+    explicit Connection(int socketFd) : fd(socketFd) {}
+};
+
+// Longest line accepted from a client before the connection is dropped.
+static const size_t MAX_LINE_BYTES = 64 * 1024;
+
+static bool isPort(const string& address) {
+    return !address.empty() && address.size() <= 5 &&
+           all_of(address.begin(), address.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+static int openListener(const string& address) {
+    int fd;
+    if (isPort(address)) {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        
+        sockaddr_in local;
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(stoi(address));
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        sockaddr_un local;
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        if (address.size() >= sizeof(local.sun_path)) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        memcpy(local.sun_path, address.c_str(), address.size());
+        
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        unlink(address.c_str()); // left over from a previous run
+        if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    
+    if (listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void watch(int epollFd, int op, int fd, uint32_t events) {
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = fd;
+    epoll_ctl(epollFd, op, fd, &event);
+}
+
+// Reads whatever has arrived and runs every complete line. Returns the
+// number of commands run.
+static size_t readCommands(RentalEngine& engine, Connection& connection) {
+    char chunk[16 * 1024];
+    while (true) {
+        ssize_t n = read(connection.fd, chunk, sizeof(chunk));
+        if (n > 0) {
+            connection.input.append(chunk, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            connection.closing = true;
+        }
+        break;
+    }
+    
+    size_t commands = 0;
+    string_view buffer = connection.input;
+    size_t end;
+    while ((end = buffer.find('\n')) != string_view::npos) {
+        string_view line = buffer.substr(0, end);
+        buffer.remove_prefix(end + 1);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+        
+        runCommand(engine, line, connection.output);
+        commands++;
+    }
+    connection.input.erase(0, connection.input.size() - buffer.size());
+    
+    if (connection.input.size() > MAX_LINE_BYTES) {
+        connection.closing = true;
+    }
+    return commands;
+}
+
+// Sends as much pending output as the socket takes. Returns false once the
+// connection should be closed.
+static bool sendAnswers(int epollFd, Connection& connection) {
+    while (connection.sent < connection.output.size()) {
+        ssize_t n = send(connection.fd, connection.output.data() + connection.sent,
+                         connection.output.size() - connection.sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0) return false;
+        connection.sent += n;
+    }
+    
+    bool drained = connection.sent == connection.output.size();
+    if (drained) {
+        connection.output.clear();
+        connection.sent = 0;
+    }
+    if (drained == connection.watchingWrites) {
+        connection.watchingWrites = !drained;
+        watch(epollFd, EPOLL_CTL_MOD, connection.fd,
+              EPOLLIN | EPOLLRDHUP | (connection.watchingWrites ? (uint32_t)EPOLLOUT : 0));
+    }
+    return !(connection.closing && drained);
+}
+
+int runServer(RentalEngine& engine, const string& address) {
+    int listenFd = openListener(address);
+    if (listenFd < 0) {
+        cout << "Could not listen on " << address << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    watch(epollFd, EPOLL_CTL_ADD, listenFd, EPOLLIN);
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop; // no SA_RESTART, so epoll_wait wakes up
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    
+    cout << "Serving on " << (isPort(address) ? "127.0.0.1:" : "") << address
+         << ". Press Ctrl+C to stop." << endl;
+    
+    // Connections indexed by socket descriptor
+    vector<unique_ptr<Connection>> connections;
+    vector<Connection*> touched;
+    vector<epoll_event> events(1024);
+    size_t accepted = 0;
+    size_t commands = 0;
+    
+    while (!stopRequested) {
+        int ready = epoll_wait(epollFd, events.data(), events.size(), 1000);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            cout << "Server error: " << strerror(errno) << endl;
+            break;
+        }
+        
+        engine.refresh();
+        engine.beginBatch();
+        
+        for (int i = 0; i < ready; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                int client;
+                while ((client = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    if ((size_t)client >= connections.size()) {
+                        connections.resize(client + 1);
+                    }
+                    connections[client].reset(new Connection(client));
+                    watch(epollFd, EPOLL_CTL_ADD, client, EPOLLIN | EPOLLRDHUP);
+                    accepted++;
+                }
+                continue;
+            }
+            
+            Connection* connection = connections[fd].get();
+            if (!connection) continue;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                commands += readCommands(engine, *connection);
+            }
+            if (!connection->queued) {
+                connection->queued = true;
+                touched.push_back(connection);
+            }
+        }
+        
+        engine.commitBatch();
+        
+        for (Connection* connection : touched) {
+            connection->queued = false;
+            if (!sendAnswers(epollFd, *connection)) {
+                int fd = connection->fd;
+                close(fd);
+                connections[fd].reset();
+            }
+        }
+        touched.clear();
+    }
+    
+    for (auto& connection : connections) {
+        if (connection) close(connection->fd);
+    }
+    close(epollFd);
+    close(listenFd);
+    if (!isPort(address)) {
+        unlink(address.c_str());
+    }
+    
+    cout << "Server stopped after " << commands << " command(s) from "
+         << accepted << " connection(s)." << endl;
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef RENTAL_PROTOCOL_H
+#define RENTAL_PROTOCOL_H
+
+// Line protocol shared by batch mode and the socket server. One command
+// per line, fields separated by '|':
+//   add-car|<company>|<model>|<daily rent>
+//   rent|<car id>|<customer>|<dd mm yyyy>
+//   reserve|<car id>|<customer>|<start dd mm yyyy>|<return dd mm yyyy>
+//   return|<rental id>
+//   query|available
+//   query|cars|<company>|<model text>|<min rent>|<max rent>|<available 0/1>|<fleet|cheapest|priciest>|<limit>
+//   query|free|<first dd mm yyyy>|<last dd mm yyyy>
+//   query|calendar|<first dd mm yyyy>|<days>[|<company>]
+//   query|revenue|<first dd mm yyyy>|<last dd mm yyyy>
+//   query|companies
+//   query|car|<car id>
+//   query|rental|<rental id>
+//   query|customers|<name prefix>
+//   query|customer|<name>
+//   query|history|<first row>|<row count>
+//   query|stats
+// Fields of query|cars may be left empty or cut off to skip that filter.
+// Each command answers with a final "ok ..." or "error ..." line. Query
+// rows come before it, cars and rentals in the data file format and the
+// rest as:
+//   calendar   <dd mm yyyy>|<free cars>
+//   revenue    <revenue>|<rented car-days>
+//   companies  <company>|<cars>|<revenue>|<rented car-days>
+//   customers  <customer id>|<name>|<open rentals>|<all rentals>
+//   stats      <operation>|<count>|<mean ns>|<p50 ns>|<p99 ns>|<max ns>
+//              for every timer, then <counter>|<value>
+
+#include "rental_engine.h"
+
+#include <string>
+#include <string_view>
+
+// Runs one command line, appending its full answer to out. Returns false
+// if the answer was an error.
+bool runCommand(RentalEngine& engine, std::string_view line, std::string& out);
+
+// Serves the protocol on address until SIGINT or SIGTERM. An address made
+// of digits is a TCP port on 127.0.0.1, anything else a Unix socket path.
+// Returns the process exit code.
+int runServer(RentalEngine& engine, const std::string& address);
+
+#endif
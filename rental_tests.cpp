@@ -0,0 +1,539 @@
+// Regression tests for the rental engine. Each test checks one engine
+// path against a plain reimplementation or against a reload of the data.
+// Build and run with
+//   cmake -S . -B build && cmake --build build && ctest --test-dir build
+// The program exits non-zero if any check fails.
+
+#include "rental_engine.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <cstdlib>
+
+using namespace std;
+
+// ==================== Helpers ====================
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << endl; \
+            failures++; \
+        } \
+    } while (0)
+
+// Fresh directory under the system temp directory, removed on scope exit.
+struct TempDir {
+    string path;
+
+    TempDir() {
+        string pattern = (filesystem::temp_directory_path() / "rental_tests.XXXXXX").string();
+        if (!mkdtemp(pattern.data())) {
+            cerr << "Could not create a temporary directory." << endl;
+            exit(1);
+        }
+        path = pattern;
+    }
+
+    ~TempDir() {
+        filesystem::remove_all(path);
+    }
+};
+
+Date daysFromToday(int days) {
+    return Date::fromSerial(getToday().serial + days);
+}
+
+void writeFile(const string& directory, const string& name, const string& contents) {
+    ofstream file(filesystem::path(directory) / name);
+    file << contents;
+}
+
+vector<string> carLines(const RentalEngine& engine) {
+    vector<string> lines;
+    for (size_t slot = 0; slot < engine.fleet().size(); slot++) {
+        lines.push_back(engine.fleet().get(slot).toFileString());
+    }
+    sort(lines.begin(), lines.end());
+    return lines;
+}
+
+vector<string> rentalLines(const RentalEngine& engine) {
+    vector<string> lines;
+    for (const auto* table : {&engine.activeRentals(), &engine.rentalArchive()}) {
+        for (const Rental& rental : *table) {
+            lines.push_back(rental.toFileString());
+        }
+    }
+    sort(lines.begin(), lines.end());
+    return lines;
+}
+
+// ==================== Dates ====================
+
+// Walks the calendar a day at a time from 1900 to 2100 and checks that
+// serials count the days exactly and convert back to the same date.
+void testDateArithmetic() {
+    int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int32_t serial = Date(1, 1, 1900).serial;
+    for (int y = 1900; y <= 2100; y++) {
+        bool isLeap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+        for (int m = 1; m <= 12; m++) {
+            int days = m == 2 && isLeap ? 29 : daysInMonth[m - 1];
+            CHECK(!Date::isValid(days + 1, m, y));
+            for (int d = 1; d <= days; d++, serial++) {
+                Date date(d, m, y);
+                if (date.serial != serial || date.day() != d || date.month() != m || date.year() != y) {
+                    CHECK(date.serial == serial);
+                    CHECK(date.day() == d && date.month() == m && date.year() == y);
+                    return;
+                }
+            }
+        }
+    }
+
+    CHECK(Date(1, 3, 2024).serial - Date(28, 2, 2024).serial == 2);
+    CHECK(Date(1, 3, 2023).serial - Date(28, 2, 2023).serial == 1);
+    CHECK(Date(1, 3, 2100).serial - Date(28, 2, 2100).serial == 1);
+    CHECK(Date(31, 1, 2024).differenceInDays(Date(1, 2, 2024)) == 1);
+    CHECK(Date(1, 1, 2024).differenceInDays(Date(1, 1, 2025)) == 366);
+    CHECK(Date(1, 1, 2025).differenceInDays(Date(1, 1, 2024)) == -366);
+    CHECK(Date(1, 1, 1970).serial == 0);
+
+    Date parsed;
+    CHECK(Date::parse("29 2 2024", parsed) && parsed == Date(29, 2, 2024));
+    CHECK(parsed.toFileString() == "29 2 2024" && parsed.toString() == "29/2/2024");
+    CHECK(Date::parse(" 5  11 2031 ", parsed) && parsed == Date(5, 11, 2031));
+    CHECK(!Date::parse("29 2 2023", parsed));
+    CHECK(!Date::parse("1 13 2024", parsed));
+    CHECK(!Date::parse("1 1", parsed));
+    CHECK(!Date::parse("1 1 2024 7", parsed));
+}
+
+// ==================== Record Ids ====================
+
+// Ids index dense tables, so rows with huge ids must be skipped rather
+// than sizing those tables.
+void testOutOfRangeIds() {
+    TempDir directory;
+    writeFile(directory.path, "cars_data.txt", "1|Toyota|Corolla|40|1\n"
+                                               "2147483647|Honda|Civic|30|1\n");
+    writeFile(directory.path, "rentals_data.txt", "2000000000|1|Ann Smith|1 1 2024|3 1 2024|80|0\n"
+                                                  "2147483647|1|Ann Smith|1 1 2024|3 1 2024|80|0\n"
+                                                  "5|1|Bob Jones|1 1 2024|3 1 2024|80|0\n");
+    writeFile(directory.path, "id_counter.txt", "2147483647 2147483647\n");
+    RentalEngine engine(directory.path, nullptr);
+    CHECK(engine.fleet().size() == 1);
+    CHECK(engine.rentalCount() == 1);
+    CHECK(engine.lookupRental(5).ok());
+    Result<int> car = engine.addCar("Kia", "Rio", 20);
+    CHECK(car.ok() && car.value == 2);
+    Result<Rental> rental = engine.rent(1, "Cy Young", daysFromToday(2));
+    CHECK(rental.ok() && rental.value.id == 6);
+}
+
+// Next ids come from the records themselves, in either storage format.
+// A counter file left by an older version only raises them once and is
+// removed by the first save.
+void testDerivedIds() {
+    TempDir directory;
+    auto exists = [&](const char* name) {
+        return filesystem::exists(filesystem::path(directory.path) / name);
+    };
+    writeFile(directory.path, "cars_data.txt", "1|Toyota|Corolla|40|1\n"
+                                               "3|Honda|Civic|30|1\n");
+    writeFile(directory.path, "rentals_data.txt", "4|1|Ann Smith|1 1 2024|3 1 2024|80|0\n");
+    writeFile(directory.path, "id_counter.txt", "7 12\n");
+    {
+        RentalEngine engine(directory.path, nullptr);
+        CHECK(!exists("id_counter.txt"));
+        Result<int> car = engine.addCar("Kia", "Rio", 20);
+        CHECK(car.ok() && car.value == 7);
+        Result<Rental> rental = engine.rent(3, "Bob Jones", daysFromToday(2));
+        CHECK(rental.ok() && rental.value.id == 12);
+    }
+    {
+        RentalEngine engine(directory.path, nullptr);
+        Result<int> car = engine.addCar("Kia", "Picanto", 20);
+        CHECK(car.ok() && car.value == 8);
+        Result<Rental> rental = engine.rent(1, "Cy Young", daysFromToday(2));
+        CHECK(rental.ok() && rental.value.id == 13);
+        CHECK(engine.convertStorage(true));
+    }
+    // A counter file older than the data must not lower the ids
+    writeFile(directory.path, "id_counter.txt", "2 2\n");
+    RentalEngine engine(directory.path, nullptr);
+    CHECK(!exists("id_counter.txt"));
+    Result<int> car = engine.addCar("Kia", "Ceed", 20);
+    CHECK(car.ok() && car.value == 9);
+    Result<Rental> rental = engine.rent(7, "Dee Park", daysFromToday(2));
+    CHECK(rental.ok() && rental.value.id == 14);
+}
+
+// ==================== Fleet Search ====================
+
+// The answer select() should give, worked out by checking every car.
+vector<int> bruteForceSelect(const FleetTable& fleet, const FleetQuery& query) {
+    auto lower = [](string_view text) {
+        string result(text);
+        transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return tolower(c); });
+        return result;
+    };
+    string part = lower(query.modelContains);
+
+    vector<size_t> slots;
+    for (size_t slot = 0; slot < fleet.size(); slot++) {
+        int rent = fleet.dailyRent(slot);
+        if (rent < query.minRent || rent > query.maxRent) continue;
+        if (query.availableOnly && !fleet.isAvailable(slot)) continue;
+        if (!query.company.empty() && fleet.company(slot) != query.company) continue;
+        if (lower(fleet.model(slot)).find(part) == string::npos) continue;
+        slots.push_back(slot);
+    }
+    if (query.order == FleetQuery::Order::RentAscending) {
+        stable_sort(slots.begin(), slots.end(), [&](size_t a, size_t b) {
+            return fleet.dailyRent(a) < fleet.dailyRent(b);
+        });
+    } else if (query.order == FleetQuery::Order::RentDescending) {
+        reverse(slots.begin(), slots.end());
+        stable_sort(slots.begin(), slots.end(), [&](size_t a, size_t b) {
+            return fleet.dailyRent(a) > fleet.dailyRent(b);
+        });
+    }
+    if (query.limit > 0 && slots.size() > query.limit) {
+        slots.resize(query.limit);
+    }
+
+    vector<int> ids;
+    for (size_t slot : slots) {
+        ids.push_back(fleet.id(slot));
+    }
+    return ids;
+}
+
+void testFleetSelect() {
+    const char* const companies[] = {"Toyota", "Honda", "Ford", "Kia", "BMW", "Tesla"};
+    const char* const models[] = {"Compact", "Sedan", "SUV", "Crossover SUV", "Minivan", "Pickup"};
+    mt19937 random(7);
+    auto randomCar = [&](int id) {
+        Car car(id, symbols().intern(companies[random() % 6]), symbols().intern(models[random() % 6]),
+                20 + random() % 200);
+        car.isAvailable = random() % 3 != 0;
+        return car;
+    };
+
+    FleetTable fleet;
+    int nextId = 1;
+    for (int i = 0; i < 1500; i++) {
+        fleet.add(randomCar(nextId++));
+    }
+
+    vector<string> plansSeen;
+    for (int round = 0; round < 3000; round++) {
+        // Change and add cars between queries so the indexes must keep up
+        if (round % 10 == 0) {
+            size_t slot = random() % fleet.size();
+            fleet.set(slot, randomCar(fleet.id(slot)));
+            fleet.add(randomCar(nextId++));
+        }
+
+        FleetQuery query;
+        if (random() % 2) query.company = random() % 10 ? companies[random() % 6] : "Nobody";
+        if (random() % 3 == 0) query.modelContains = vector<string>{"suv", "S", "van", "x", "sedan"}[random() % 5];
+        if (random() % 2) query.minRent = 20 + random() % 200;
+        if (random() % 2) query.maxRent = query.minRent == numeric_limits<int>::min() ? 20 + random() % 200
+                                                                                    : query.minRent + random() % 40;
+        query.availableOnly = random() % 2;
+        query.order = (FleetQuery::Order)(random() % 3);
+        query.limit = vector<size_t>{0, 1, 5, 50}[random() % 4];
+
+        FleetQueryPlan plan;
+        vector<int> found = fleet.select(query, &plan);
+        CHECK(found == bruteForceSelect(fleet, query));
+        if (find(plansSeen.begin(), plansSeen.end(), plan.index) == plansSeen.end()) {
+            plansSeen.push_back(plan.index);
+        }
+    }
+    // Every plan has to have been compared at least once
+    CHECK(plansSeen.size() == 3);
+}
+
+// ==================== Reservations ====================
+
+// Bookings of one car may touch but not overlap, and must start within
+// the booking horizon and last at most MAX_RENTAL_DAYS.
+void testReservationRules() {
+    TempDir directory;
+    RentalEngine engine(directory.path, nullptr);
+    CHECK(engine.addCar("Toyota", "Corolla", 40).ok());
+    CHECK(engine.addCar("Honda", "Civic", 30).ok());
+    auto reserve = [&](int carId, int first, int last) {
+        return engine.reserve(carId, "Ann Smith", daysFromToday(first), daysFromToday(last)).status;
+    };
+
+    CHECK(reserve(1, 10, 20) == RentalStatus::Ok);
+    CHECK(reserve(1, 15, 25) == RentalStatus::CarBooked);
+    CHECK(reserve(1, 5, 10) == RentalStatus::CarBooked);
+    CHECK(reserve(1, 20, 22) == RentalStatus::CarBooked);
+    CHECK(reserve(1, 12, 14) == RentalStatus::CarBooked);
+    CHECK(reserve(1, 5, 9) == RentalStatus::Ok);
+    CHECK(reserve(1, 21, 30) == RentalStatus::Ok);
+    CHECK(reserve(2, 12, 14) == RentalStatus::Ok);
+
+    // A rental from today must end before the first reservation starts
+    CHECK(engine.rent(1, "Bob Jones", daysFromToday(5)).status == RentalStatus::CarBooked);
+    CHECK(engine.rent(1, "Bob Jones", daysFromToday(4)).ok());
+    CHECK(engine.freeCars(daysFromToday(11), daysFromToday(13)).empty());
+    CHECK(engine.freeCars(daysFromToday(15), daysFromToday(18)) == vector<int>{2});
+    CHECK(engine.freeCars(daysFromToday(40), daysFromToday(50)).size() == 2);
+
+    CHECK(reserve(2, -1, 3) == RentalStatus::StartDateInPast);
+    CHECK(reserve(2, BOOKING_HORIZON_DAYS + 1, BOOKING_HORIZON_DAYS + 3) == RentalStatus::StartDateTooFar);
+    CHECK(reserve(2, BOOKING_HORIZON_DAYS, BOOKING_HORIZON_DAYS + 3) == RentalStatus::Ok);
+    CHECK(reserve(1, 40, 40 + MAX_RENTAL_DAYS + 1) == RentalStatus::RentalTooLong);
+    CHECK(reserve(1, 40, 40 + MAX_RENTAL_DAYS) == RentalStatus::Ok);
+    CHECK(reserve(1, 35, 35) == RentalStatus::ReturnBeforeStart);
+    CHECK(reserve(1, 35, 33) == RentalStatus::ReturnBeforeStart);
+
+    // Cancelling a reservation frees its days again
+    Result<Rental> middle = engine.lookupRental(1);
+    CHECK(middle.ok() && engine.returnRental(middle.value.id).ok());
+    CHECK(reserve(1, 15, 18) == RentalStatus::Ok);
+}
+
+// ==================== Journal Replay ====================
+
+// Copies the data directory while the engine is still running, as a crash
+// would leave it, and checks that replaying the journal rebuilds the same
+// cars and rentals.
+void testJournalReplay() {
+    TempDir live, crashed;
+    vector<string> cars, rentals;
+    {
+        RentalEngine engine(live.path, nullptr);
+        for (int i = 0; i < 6; i++) {
+            CHECK(engine.addCar(i % 2 ? "Honda" : "Toyota", "Model " + to_string(i), 30 + i).ok());
+        }
+        Result<Rental> first = engine.rent(1, "Ann Smith", daysFromToday(3));
+        Result<Rental> second = engine.rent(2, "Bob Jones", daysFromToday(5));
+        Result<Rental> reserved = engine.reserve(3, "Ann Smith", daysFromToday(4), daysFromToday(9));
+        Result<Rental> cancelled = engine.reserve(4, "Cy Young", daysFromToday(2), daysFromToday(6));
+        CHECK(first.ok() && second.ok() && reserved.ok() && cancelled.ok());
+        CHECK(engine.returnRental(first.value.id).ok());
+        CHECK(engine.returnRental(cancelled.value.id).ok());
+        CHECK(!engine.rent(2, "Dee Park", daysFromToday(2)).ok());
+
+        cars = carLines(engine);
+        rentals = rentalLines(engine);
+        filesystem::copy(live.path, crashed.path, filesystem::copy_options::recursive |
+                                                   filesystem::copy_options::overwrite_existing);
+    }
+    CHECK(filesystem::file_size(filesystem::path(crashed.path) / "journal.txt") > 0);
+
+    RentalEngine replayed(crashed.path, nullptr);
+    CHECK(carLines(replayed) == cars);
+    CHECK(rentalLines(replayed) == rentals);
+    CHECK(!replayed.fleet().isAvailable(replayed.fleet().slotOf(2)));
+    CHECK(!replayed.rent(3, "Eve Lee", daysFromToday(6)).ok());
+    CHECK(replayed.rent(1, "Eve Lee", daysFromToday(2)).ok());
+}
+
+// Desks renting and returning the same few cars at once must leave a
+// journal that replays to the state they left behind.
+void testConcurrentJournal() {
+    TempDir live, crashed;
+    vector<string> rentals;
+    {
+        RentalEngine engine(live.path, nullptr);
+        for (int i = 0; i < 3; i++) {
+            CHECK(engine.addCar("Toyota", "Model " + to_string(i), 40).ok());
+        }
+        vector<thread> desks;
+        for (int desk = 0; desk < 4; desk++) {
+            desks.emplace_back([&engine, desk] {
+                for (int i = 0; i < 150; i++) {
+                    int carId = 1 + (desk + i) % 3;
+                    Result<Rental> rental = i % 2 ? engine.reserve(carId, "Desk " + to_string(desk),
+                                                                   daysFromToday(1 + i % 5), daysFromToday(7))
+                                                  : engine.rent(carId, "Desk " + to_string(desk), daysFromToday(3));
+                    if (rental.ok()) engine.returnRental(rental.value.id);
+                }
+            });
+        }
+        for (auto& desk : desks) {
+            desk.join();
+        }
+        CHECK(engine.activeRentals().empty());
+        rentals = rentalLines(engine);
+        filesystem::copy(live.path, crashed.path, filesystem::copy_options::recursive |
+                                                   filesystem::copy_options::overwrite_existing);
+    }
+
+    RentalEngine replayed(crashed.path, nullptr);
+    CHECK(rentalLines(replayed) == rentals);
+    CHECK(replayed.activeRentals().empty());
+}
+
+// A booking record met after the record of its return is stale: the
+// rental must stay returned, with the return's amount.
+void testStaleJournalRecord() {
+    TempDir directory;
+    string start, end;
+    daysFromToday(2).appendTo(start);
+    daysFromToday(5).appendTo(end);
+    writeFile(directory.path, "cars_data.txt", "1|Toyota|Corolla|40|1\n");
+    writeFile(directory.path, "journal.txt", "R|1|1|Ann Smith|" + start + "|" + end + "|0|0\n"
+                                             "R|1|1|Ann Smith|" + start + "|" + end + "|120|1\n");
+    RentalEngine engine(directory.path, nullptr);
+    Result<Rental> rental = engine.lookupRental(1);
+    CHECK(rental.ok() && !rental.value.isActive && rental.value.totalAmount == 0);
+    Result<UsageTotals> usage = engine.carUsage(1);
+    CHECK(usage.ok() && usage.value.revenue == 0 && usage.value.rentedDays == 0);
+    CHECK(engine.reserve(1, "Bob Jones", daysFromToday(2), daysFromToday(5)).ok());
+}
+
+// ==================== Binary Snapshot ====================
+
+// Converting to the binary snapshot and back must keep every car and
+// rental, and leave only the files of the current format behind.
+void testSnapshotRoundTrip() {
+    TempDir directory;
+    auto exists = [&](const char* name) {
+        return filesystem::exists(filesystem::path(directory.path) / name);
+    };
+    vector<string> cars, rentals;
+    {
+        RentalEngine engine(directory.path, nullptr);
+        for (int i = 0; i < 4; i++) {
+            CHECK(engine.addCar(i % 2 ? "Honda" : "Toyota", "Model " + to_string(i), 30 + i).ok());
+        }
+        Result<Rental> early = engine.rent(1, "Ann Smith", daysFromToday(6));
+        CHECK(early.ok() && engine.returnRental(early.value.id).ok());
+        CHECK(engine.rent(2, "Bob Jones", daysFromToday(3)).ok());
+        CHECK(engine.reserve(3, "Ann Smith", daysFromToday(5), daysFromToday(8)).ok());
+        CHECK(engine.convertStorage(true));
+        CHECK(!engine.convertStorage(true));
+        cars = carLines(engine);
+        rentals = rentalLines(engine);
+    }
+    CHECK(exists("data_snapshot.bin") && !exists("cars_data.txt") && !exists("rentals_data.txt"));
+    {
+        RentalEngine engine(directory.path, nullptr);
+        CHECK(carLines(engine) == cars);
+        CHECK(rentalLines(engine) == rentals);
+        Result<Rental> early = engine.lookupRental(1);
+        CHECK(early.ok() && early.value.returnDate == daysFromToday(6) && early.value.returnedOn == getToday());
+        CHECK(engine.convertStorage(false));
+    }
+    CHECK(!exists("data_snapshot.bin") && exists("cars_data.txt") && exists("rentals_data.txt"));
+    RentalEngine engine(directory.path, nullptr);
+    CHECK(carLines(engine) == cars);
+    CHECK(rentalLines(engine) == rentals);
+    CHECK(engine.rent(4, "Cy Young", daysFromToday(2)).ok());
+}
+
+// ==================== Revenue Ledger ====================
+
+// Renting one car and bringing it back early, again and again, must not
+// count more car-days than the car was out, before or after a reload.
+void testLedgerUtilization() {
+    TempDir directory;
+    auto checkUsage = [](const RentalEngine& engine) {
+        UsageTotals usage = engine.usageBetween(getToday(), daysFromToday(30));
+        CHECK(usage.rentedDays == 10);
+        CHECK(usage.revenue == 4 * 400);
+        Result<UsageTotals> car = engine.carUsage(1);
+        CHECK(car.ok() && car.value.rentedDays == 10 && car.value.revenue == 4 * 400);
+    };
+    {
+        RentalEngine engine(directory.path, nullptr);
+        CHECK(engine.addCar("Toyota", "Corolla", 40).ok());
+        for (int i = 0; i < 3; i++) {
+            Result<Rental> rental = engine.rent(1, "Ann Smith", daysFromToday(10));
+            CHECK(rental.ok() && rental.value.totalAmount == 400);
+            Result<Rental> returned = engine.returnRental(rental.ok() ? rental.value.id : -1);
+            // The booked return date is kept next to the day it came back
+            CHECK(returned.ok() && returned.value.returnDate == daysFromToday(10));
+            CHECK(returned.ok() && returned.value.returnedOn == getToday());
+        }
+        // A reservation cancelled before it starts leaves no trace
+        Result<Rental> cancelled = engine.reserve(1, "Bob Jones", daysFromToday(12), daysFromToday(20));
+        CHECK(cancelled.ok() && engine.returnRental(cancelled.value.id).ok());
+        CHECK(engine.rent(1, "Cy Young", daysFromToday(10)).ok());
+        checkUsage(engine);
+    }
+    RentalEngine reloaded(directory.path, nullptr);
+    checkUsage(reloaded);
+    Result<Rental> first = reloaded.lookupRental(1);
+    CHECK(first.ok() && first.value.returnDate == daysFromToday(10) && first.value.returnedOn == getToday());
+}
+
+// ==================== Customers ====================
+
+// Prefix search ignores case and honours the limit, and customer ids are
+// the first rental ids, so they survive a reload.
+void testCustomerSearch() {
+    TempDir directory;
+    auto summaries = [](const RentalEngine& engine, string_view prefix, size_t limit) {
+        vector<string> rows;
+        for (const auto& customer : engine.findCustomers(prefix, limit)) {
+            rows.push_back(to_string(customer.id) + "|" + customer.name + "|" +
+                           to_string(customer.activeRentals) + "|" + to_string(customer.totalRentals));
+        }
+        return rows;
+    };
+    vector<string> before;
+    {
+        RentalEngine engine(directory.path, nullptr);
+        for (int i = 0; i < 4; i++) {
+            CHECK(engine.addCar("Toyota", "Model " + to_string(i), 40).ok());
+        }
+        CHECK(engine.rent(1, "maria lopez", daysFromToday(2)).ok());
+        Result<Rental> returned = engine.rent(2, "Mark Stone", daysFromToday(3));
+        CHECK(returned.ok() && engine.returnRental(returned.value.id).ok());
+        CHECK(engine.rent(3, "Mark Stone", daysFromToday(3)).ok());
+        CHECK(engine.rent(4, "Anna Marsh", daysFromToday(3)).ok());
+
+        before = summaries(engine, "MAR", 10);
+        CHECK(before == (vector<string>{"1|maria lopez|1|1", "2|Mark Stone|1|2"}));
+        CHECK(summaries(engine, "mar", 1) == vector<string>{"1|maria lopez|1|1"});
+        CHECK(summaries(engine, "Marsh", 10).empty());
+        CHECK(summaries(engine, "", 10).size() == 3);
+        CHECK(engine.customerRentals("MARK STONE").empty());
+        CHECK(engine.customerRentals("Mark Stone").size() == 2);
+        CHECK(engine.customerRentals("Mark Stone", true).size() == 1);
+    }
+    RentalEngine reloaded(directory.path, nullptr);
+    CHECK(summaries(reloaded, "mar", 10) == before);
+}
+
+// ==================== Main Function ====================
+
+int main() {
+    testDateArithmetic();
+    testOutOfRangeIds();
+    testDerivedIds();
+    testFleetSelect();
+    testReservationRules();
+    testJournalReplay();
+    testConcurrentJournal();
+    testStaleJournalRecord();
+    testSnapshotRoundTrip();
+    testLedgerUtilization();
+    testCustomerSearch();
+
+    if (failures > 0) {
+        cerr << failures << " check(s) failed." << endl;
+        return 1;
+    }
+    cout << "All checks passed." << endl;
+    return 0;
+}